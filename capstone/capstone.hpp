@@ -14,6 +14,7 @@
 
 // required libraries
 #include <Arduino.h>
+#include <avr/eeprom.h>
 #include <Wire.h>
 #include "LiquidCrystal_I2C.h"
 
@@ -29,6 +30,25 @@
 #define ROUND(val)        (static_cast<BigInt_t>((val) + 0.5))
 #define Apin(pin_no)      A##pin_no
 #define Dpin(pin_no)      pin_no
+#define FLASH_STR(ptr)    (reinterpret_cast<__FlashStringHelper const *>(ptr))
+#define ADC_READERS_MAX   8
+#define ADC_WINDOW_LEN    64
+#define ADC_WINDOW_MIN    4
+#define ADC_WINDOW_MAX    128
+#define ADC_TARGET_ERROR  2
+#define ADC_FRACTION_BITS 4
+#define PIN_GROUP_MAX     16
+#define LCD_SHADOWS_MAX   2
+#define TRIP_STRIKES      3
+#define SERIAL_MESSAGES_MAX 16
+#define SERIAL_DROP_NEWEST 0
+#define SERIAL_DROP_OLDEST 1
+#define TELEMETRY_TEXT    0
+#define TELEMETRY_BINARY  1
+#define TELEMETRY_LEN_MAX 64
+#define EEPROM_RECORD_MAX 64
+#define SOC_COULOMB       0
+#define SOC_EKF           1
 /* Comments
 ** [LCD_SECTION_LEN]
 ** 1. `LCD_SECTION_LEN` returns the length of sections.
@@ -42,21 +62,83 @@
 ** [Dpin]
 ** 1. `Dpin` stands for digital pin.
 ** 2. For example, `Dpin(2)` refers to the digital pin `2`.
+** [FLASH_STR]
+** 1. `FLASH_STR(ptr)` casts `ptr`, which points to a string placed by `PROGMEM`, into the type of `F("...")`.
+** [ADC_READERS_MAX]
+** 1. `ADC_READERS_MAX` is the maximum number of `PinReader`s the ADC sampler can cycle through.
+** [ADC_WINDOW_LEN]
+** 1. `ADC_WINDOW_LEN` is the number of samples per channel averaged into the first window by the ADC sampler.
+** [ADC_WINDOW_MIN]
+** 1. `ADC_WINDOW_MIN` is the least number of samples of a window, which is a power of 2.
+** [ADC_WINDOW_MAX]
+** 1. `ADC_WINDOW_MAX` is the greatest number of samples of a window, which is a power of 2 up to 128.
+** [ADC_TARGET_ERROR]
+** 1. `ADC_TARGET_ERROR` is the default standard error of the average of a window in units of `Sig_t`,
+**    i.e. an eighth of a count with `ADC_FRACTION_BITS == 4`,
+**    which takes 64 samples of a tap whose noise is a count.
+** [ADC_FRACTION_BITS]
+** 1. `ADC_FRACTION_BITS` is the number of fractional bits of `Sig_t`.
+** [PIN_GROUP_MAX]
+** 1. `PIN_GROUP_MAX` is the maximum number of `PinSetter`s in a `PinGroup`.
+** [LCD_SHADOWS_MAX]
+** 1. `LCD_SHADOWS_MAX` is the maximum number of `LcdHandle_t`s whose screens are shadowed by `LcdPrinter` at once.
+** [TRIP_STRIKES]
+** 1. `TRIP_STRIKES` is the number of consecutive samples violating a limit which make `TripGuard` trip.
+** [SERIAL_MESSAGES_MAX]
+** 1. `SERIAL_MESSAGES_MAX` is the maximum number of messages in the serial ring buffer at once.
+** 2. The length of every message is kept, so a message is discarded without scanning the buffer;
+**    a message beyond `SERIAL_MESSAGES_MAX` does not fit, as one beyond `SERIAL_RING_LEN` characters does not.
+** [SERIAL_DROP_NEWEST]
+** 1. If `SERIAL_OVERFLOW` is `SERIAL_DROP_NEWEST`,
+**    the message which does not fit in the serial ring buffer is discarded.
+** [SERIAL_DROP_OLDEST]
+** 1. If `SERIAL_OVERFLOW` is `SERIAL_DROP_OLDEST`,
+**    the oldest messages in the serial ring buffer are discarded to make room,
+**    except the one which the port has begun to send.
+** 2. A message which would not fit even if all of them were discarded is discarded first,
+**    so it never evicts the others in vain.
+**    Its length is judged as far as it is queued, i.e. a string up to its `'\n'` or the bytes of a call at once.
+** [TELEMETRY_TEXT]
+** 1. If `TELEMETRY_MODE` is `TELEMETRY_TEXT`,
+**    measured values are reported as human-readable lines through `sout`.
+** [TELEMETRY_BINARY]
+** 1. If `TELEMETRY_MODE` is `TELEMETRY_BINARY`,
+**    measured values are reported as frames of `TelemetryFrame`.
+** [TELEMETRY_LEN_MAX]
+** 1. `TELEMETRY_LEN_MAX` is the maximum length of the payload of `TelemetryFrame`.
+** [EEPROM_RECORD_MAX]
+** 1. `EEPROM_RECORD_MAX` is the maximum length of a record of `EepromRing`, including its sequence number and CRC.
+** [SOC_COULOMB]
+** 1. If `SOC_ESTIMATOR` is `SOC_COULOMB`,
+**    the SOC is the initial OCV estimate plus the charge counted by `CoulombCounter`.
+** [SOC_EKF]
+** 1. If `SOC_ESTIMATOR` is `SOC_EKF`,
+**    the SOC is estimated by `SocEstimator` for every cell.
+** 2. It is experimental: unless `CellStates::ecms` are measured for the cells,
+**    it is less accurate than `SOC_COULOMB` with a calibrated current sensor.
 */
 
 // type synonym defns
 typedef int long long ms_t;
+typedef uint32_t us_t;
 typedef double Amp_t;
 typedef double Vol_t;
 typedef double Ohm_t;
 typedef double long mAh_t;
 typedef double Val_t;
+typedef int32_t mV_t;
+typedef int32_t mA_t;
+typedef int64_t uAms_t;
+typedef uint16_t Sig_t;
 typedef uint8_t pinId_t;
 typedef int64_t BigInt_t;
 typedef LiquidCrystal_I2C *LcdHandle_t;
 /* Comments
 ** [ms_t]
 ** 1. `ms_t` stands for the type of milliseconds.
+** [us_t]
+** 1. `us_t` stands for the type of timestamps in microseconds, which wrap around every `2^32[us]`, about 71 minutes.
+** 2. Durations are taken by the unsigned subtraction `t_1 - t_0`, which is correct across a wrap-around.
 ** [Amp_t]
 ** 1. `Amp_t` stands for the type of ampere.
 ** [Vol_t]
@@ -67,6 +149,15 @@ typedef LiquidCrystal_I2C *LcdHandle_t;
 ** 1. `mAh_t` stands for the type of milliampere hours.
 ** [Val_t]
 ** 1. `Val_t` stands for the type of the real numbers.
+** [mV_t]
+** 1. `mV_t` stands for the type of millivolts.
+** [mA_t]
+** 1. `mA_t` stands for the type of milliamperes.
+** [uAms_t]
+** 1. `uAms_t` stands for the type of charges in units of microampere milliseconds.
+** 2. `1[mAh] = 3600000000[uAms]`, hence `uAms_t` holds charges up to about `2.5 * 10^9[mAh]`.
+** [Sig_t]
+** 1. `Sig_t` stands for the type of analog signals in units of `1 / 2^ADC_FRACTION_BITS` counts.
 ** [pinId_t]
 ** 1. `pinId_t` stands for the type of pins.
 ** [BigInt_t]
@@ -79,6 +170,20 @@ typedef LiquidCrystal_I2C *LcdHandle_t;
 void invokingSerial();
 void drawlineSerial();
 BigInt_t POW(BigInt_t base, int expn);
+uint16_t CRC16(byte const *bytes, int len, uint16_t crc = 0xFFFF);
+us_t clockMicros();
+void setClockSource(us_t (*time_source)());
+constexpr uint16_t encodeU16(Val_t const val, Val_t const base, Val_t const unit)
+{
+  return static_cast<uint16_t>((val - base) / unit + 0.5);
+}
+template <typename T>
+inline T readFlash(T const *const flash_address)
+{
+  T val;
+  memcpy_P(&val, flash_address, sizeof(T));
+  return val;
+}
 template <typename UnsignedIntegers = byte>
 class BitArray {
   UnsignedIntegers my_bits;
@@ -116,43 +221,276 @@ public:
     return *this;
   }
 };
+template <int N>
+struct Unrolled {
+  template <typename Job>
+  static inline void forEach(Job const &job)
+  {
+    Unrolled<N - 1>::forEach(job);
+    job(N - 1);
+  }
+};
+template <>
+struct Unrolled<0> {
+  template <typename Job>
+  static inline void forEach(Job const &)
+  {
+  }
+};
 class Timer {
-  ms_t volatile begTime;
+  us_t begTime;
 public:
   Timer();
   Timer(Timer const &other) = delete;
   Timer(Timer &&other) = delete;
-  Timer(ms_t init_time);
+  Timer(us_t init_time);
   ~Timer();
   void reset();
   ms_t time() const;
   ms_t getDuration() const;
+  us_t getMicros() const;
   void delay(ms_t duration) const;
 };
+struct Task {
+  void (*const job)();
+  ms_t const period;
+  us_t next_due;
+  us_t max_jitter;
+  us_t max_duration;
+  unsigned int overruns;
+  Task(void (*job)(), ms_t period);
+};
+class Scheduler {
+  Task *const tasks;
+  int const number_of_tasks;
+  int task_to_report;
+public:
+  Scheduler() = delete;
+  Scheduler(Scheduler const &other) = delete;
+  Scheduler(Scheduler &&other) = delete;
+  template <size_t number_of_tasks_in_table>
+  Scheduler(Task (*const tasks_ref)[number_of_tasks_in_table])
+    : tasks{ *tasks_ref }
+    , number_of_tasks{ static_cast<int>(number_of_tasks_in_table) }
+    , task_to_report{ 0 }
+  {
+  }
+  ~Scheduler();
+  void start();
+  void runOnce();
+  us_t untilNextDue() const;
+  bool report();
+};
+struct Transition {
+  uint8_t from;
+  uint8_t event;
+  uint8_t to;
+  void (*action)();
+};
+class StateMachine {
+  Transition const *const transitions;
+  int const number_of_transitions;
+  bool const transitions_in_flash;
+  uint8_t state;
+public:
+  StateMachine() = delete;
+  StateMachine(StateMachine const &other) = delete;
+  StateMachine(StateMachine &&other) = delete;
+  template <size_t number_of_transitions_in_table>
+  StateMachine(Transition const (*const transitions_ref)[number_of_transitions_in_table], uint8_t const init_state, bool const in_flash = false)
+    : transitions{ *transitions_ref }
+    , number_of_transitions{ static_cast<int>(number_of_transitions_in_table) }
+    , transitions_in_flash{ in_flash }
+    , state{ init_state }
+  {
+  }
+  ~StateMachine();
+  bool raise(uint8_t event);
+  void reset(uint8_t init_state);
+  uint8_t getState() const;
+  template <size_t StateNameLen, size_t EventNameLen>
+  void dump(char const (*const state_names)[StateNameLen], char const (*const event_names)[EventNameLen]) const
+  {
+    this->dumpWith(*state_names, StateNameLen, *event_names, EventNameLen);
+  }
+private:
+  Transition transition_at(int i) const;
+  void dumpWith(char const *state_names, int state_name_len, char const *event_names, int event_name_len) const;
+};
+class CoulombCounter {
+  uAms_t twice_charge;
+  mA_t last_current;
+  us_t last_time;
+  bool has_last_sample;
+public:
+  CoulombCounter();
+  CoulombCounter(CoulombCounter const &other) = delete;
+  CoulombCounter(CoulombCounter &&other) = delete;
+  ~CoulombCounter();
+  void reset(mAh_t init_charge);
+  void integrate(us_t time, mA_t current, bool counting);
+  uAms_t get_uAms() const;
+  int32_t get_uAh() const;
+  mAh_t get_mAh() const;
+};
+class EepromRing {
+  int const base_address;
+  int const size_of_payload;
+  int const size_of_slot;
+  int const number_of_slots;
+  byte record[EEPROM_RECORD_MAX];
+  int next_slot;
+  uint16_t next_seq;
+  int cursor;
+public:
+  EepromRing() = delete;
+  EepromRing(EepromRing const &other) = delete;
+  EepromRing(EepromRing &&other) = delete;
+  EepromRing(int base_address, int size_of_payload, int size_of_ring);
+  ~EepromRing();
+  bool load(void *payload);
+  bool save(void const *payload);
+  void pump();
+  bool isBusy() const;
+};
 class AscList {
   Val_t const left_bound_of_xs;
   Val_t const right_bound_of_xs;
   Val_t const *const ys;
+  uint16_t const *const codes_of_ys;
+  Val_t const base_of_ys;
+  Val_t const unit_of_ys;
+  Val_t const codes_per_y;
+  bool const ys_in_flash;
   int const number_of_intervals;
+  uint8_t *const index_of_ys;
+  int const number_of_buckets;
+  Val_t const buckets_per_y;
 public:
   AscList() = delete;
   AscList(AscList const &other) = delete;
   AscList(AscList &&other) = delete;
   template <size_t size_of_data_sheet>
-  AscList(Val_t const (*const data_sheet_ref)[size_of_data_sheet], Val_t const left_bound, Val_t const right_bound)
+  AscList(Val_t const (*const data_sheet_ref)[size_of_data_sheet], Val_t const left_bound, Val_t const right_bound, bool const in_flash = false)
     : left_bound_of_xs{ left_bound }
     , right_bound_of_xs{ right_bound }
     , ys{ *data_sheet_ref }
+    , codes_of_ys{ nullptr }
+    , base_of_ys{ 0.0 }
+    , unit_of_ys{ 1.0 }
+    , codes_per_y{ 1.0 }
+    , ys_in_flash{ in_flash }
     , number_of_intervals{ static_cast<int>(size_of_data_sheet) - 1 }
+    , index_of_ys{ nullptr }
+    , number_of_buckets{ 0 }
+    , buckets_per_y{ 0.0 }
   {
   }
+  template <size_t size_of_data_sheet, size_t size_of_index>
+  AscList(Val_t const (*const data_sheet_ref)[size_of_data_sheet], Val_t const left_bound, Val_t const right_bound, uint8_t (*const index_ref)[size_of_index], bool const in_flash = false)
+    : left_bound_of_xs{ left_bound }
+    , right_bound_of_xs{ right_bound }
+    , ys{ *data_sheet_ref }
+    , codes_of_ys{ nullptr }
+    , base_of_ys{ 0.0 }
+    , unit_of_ys{ 1.0 }
+    , codes_per_y{ 1.0 }
+    , ys_in_flash{ in_flash }
+    , number_of_intervals{ static_cast<int>(size_of_data_sheet) - 1 }
+    , index_of_ys{ *index_ref }
+    , number_of_buckets{ static_cast<int>(size_of_index) }
+    , buckets_per_y{ size_of_index / (this->y_at(size_of_data_sheet - 1) - this->y_at(0)) }
+  {
+    static_assert(size_of_data_sheet >= 2 && size_of_data_sheet <= 256, "The index of `AscList` holds intervals as `uint8_t`.");
+    this->buildIndex();
+  }
+  template <size_t size_of_data_sheet>
+  AscList(uint16_t const (*const data_sheet_ref)[size_of_data_sheet], Val_t const base, Val_t const unit, Val_t const left_bound, Val_t const right_bound, bool const in_flash = false)
+    : left_bound_of_xs{ left_bound }
+    , right_bound_of_xs{ right_bound }
+    , ys{ nullptr }
+    , codes_of_ys{ *data_sheet_ref }
+    , base_of_ys{ base }
+    , unit_of_ys{ unit }
+    , codes_per_y{ 1.0 / unit }
+    , ys_in_flash{ in_flash }
+    , number_of_intervals{ static_cast<int>(size_of_data_sheet) - 1 }
+    , index_of_ys{ nullptr }
+    , number_of_buckets{ 0 }
+    , buckets_per_y{ 0.0 }
+  {
+  }
+  template <size_t size_of_data_sheet, size_t size_of_index>
+  AscList(uint16_t const (*const data_sheet_ref)[size_of_data_sheet], Val_t const base, Val_t const unit, Val_t const left_bound, Val_t const right_bound, uint8_t (*const index_ref)[size_of_index], bool const in_flash = false)
+    : left_bound_of_xs{ left_bound }
+    , right_bound_of_xs{ right_bound }
+    , ys{ nullptr }
+    , codes_of_ys{ *data_sheet_ref }
+    , base_of_ys{ base }
+    , unit_of_ys{ unit }
+    , codes_per_y{ 1.0 / unit }
+    , ys_in_flash{ in_flash }
+    , number_of_intervals{ static_cast<int>(size_of_data_sheet) - 1 }
+    , index_of_ys{ *index_ref }
+    , number_of_buckets{ static_cast<int>(size_of_index) }
+    , buckets_per_y{ size_of_index / (static_cast<Val_t>(this->code_at(size_of_data_sheet - 1)) - this->code_at(0)) }
+  {
+    static_assert(size_of_data_sheet >= 2 && size_of_data_sheet <= 256, "The index of `AscList` holds intervals as `uint8_t`.");
+    this->buildIndex();
+  }
   ~AscList();
   bool isValid() const;
   Val_t get_y_by_x(Val_t x) const;
+  Val_t get_slope_by_x(Val_t x) const;
   Val_t get_x_by_parameter(Val_t param) const;
   Val_t get_x_by_y(Val_t y) const;
+private:
+  uint16_t code_at(int const i) const
+  {
+    return ys_in_flash ? readFlash(&codes_of_ys[i]) : codes_of_ys[i];
+  }
+  Val_t y_at(int const i) const
+  {
+    if (codes_of_ys)
+    {
+      return base_of_ys + unit_of_ys * this->code_at(i);
+    }
+    return ys_in_flash ? readFlash(&ys[i]) : ys[i];
+  }
+  void buildIndex();
+  Val_t get_x_by_y_with_index(Val_t y) const;
+  Val_t get_x_by_y_with_codes(Val_t y) const;
 };
-template <size_t TableWidth, typename Fractional_t = Val_t>
+struct EcmParameters {
+  float capacity;
+  float R0;
+  float R1;
+  float tau;
+  float var_of_soc;
+  float var_of_Vrc;
+  float var_of_V;
+};
+class SocEstimator {
+  AscList const *ocv_table;
+  EcmParameters const *params;
+  float soc;
+  float Vrc;
+  float P[2][2];
+  uAms_t last_charge;
+  us_t last_time;
+public:
+  SocEstimator();
+  SocEstimator(SocEstimator const &other) = delete;
+  SocEstimator(SocEstimator &&other) = delete;
+  ~SocEstimator();
+  void init(AscList const *ocv_table_ref, EcmParameters const *params_ref);
+  void reset(float init_soc, uAms_t charge, us_t time);
+  void update(uAms_t charge, us_t time, mA_t current, mV_t voltage, bool measuring);
+  float get_soc() const;
+  float get_Vrc() const;
+  float get_var_of_soc() const;
+};
+template <size_t TableWidth, typename Fractional_t = Val_t, typename Entry_t = Fractional_t>
 class Map2d {
   Fractional_t const left_bound_of_xs;
   Fractional_t const right_bound_of_xs;
@@ -160,11 +498,17 @@ class Map2d {
   Fractional_t const max_of_s;
   int const number_of_intervals;
   int const number_of_s_levels;
-  Fractional_t const (*table)[TableWidth];
-  Fractional_t ys[TableWidth];
+  Entry_t const (*table)[TableWidth];
+  Fractional_t const base_of_entries;
+  Fractional_t const unit_of_entries;
+  bool const table_in_flash;
 public:
+  struct Row {
+    int idx;
+    Fractional_t weight;
+  };
   template <size_t TableHeight>
-  Map2d(Fractional_t const (*data_sheet_ref)[TableHeight][TableWidth], Fractional_t const left_bound, Fractional_t const right_bound, Fractional_t const s_min, Fractional_t const s_max)
+  Map2d(Entry_t const (*data_sheet_ref)[TableHeight][TableWidth], Fractional_t const left_bound, Fractional_t const right_bound, Fractional_t const s_min, Fractional_t const s_max, bool const in_flash = false)
     : left_bound_of_xs{ left_bound }
     , right_bound_of_xs{ right_bound }
     , min_of_s{ s_min }
@@ -172,7 +516,23 @@ public:
     , number_of_intervals{ static_cast<int>(TableWidth) - 1 }
     , number_of_s_levels{ static_cast<int>(TableHeight) - 1 }
     , table{ *data_sheet_ref }
-    , ys{ }
+    , base_of_entries{ 0 }
+    , unit_of_entries{ 1 }
+    , table_in_flash{ in_flash }
+  {
+  }
+  template <size_t TableHeight>
+  Map2d(Entry_t const (*data_sheet_ref)[TableHeight][TableWidth], Fractional_t const base, Fractional_t const unit, Fractional_t const left_bound, Fractional_t const right_bound, Fractional_t const s_min, Fractional_t const s_max, bool const in_flash = false)
+    : left_bound_of_xs{ left_bound }
+    , right_bound_of_xs{ right_bound }
+    , min_of_s{ s_min }
+    , max_of_s{ s_max }
+    , number_of_intervals{ static_cast<int>(TableWidth) - 1 }
+    , number_of_s_levels{ static_cast<int>(TableHeight) - 1 }
+    , table{ *data_sheet_ref }
+    , base_of_entries{ base }
+    , unit_of_entries{ unit }
+    , table_in_flash{ in_flash }
   {
   }
   Map2d() = delete;
@@ -185,21 +545,51 @@ public:
   {
     return ((param * (right_bound_of_xs - left_bound_of_xs) / number_of_intervals) + left_bound_of_xs);
   }
-  Fractional_t get_x_by_y(Fractional_t const y) const
+  Row get_row_by_s(Fractional_t const s) const
+  {
+    if (s <= min_of_s)
+    {
+      return { .idx = 0, .weight = 0 };
+    }
+    else if (s >= max_of_s)
+    {
+      return { .idx = number_of_s_levels, .weight = 0 };
+    }
+    else
+    {
+      Fractional_t const param_s = (s - min_of_s) * (number_of_s_levels / (max_of_s - min_of_s));
+      int const idx = param_s;
+
+      return { .idx = idx, .weight = param_s - idx };
+    }
+  }
+  Fractional_t get_y_by_row(Row const &row, int const i) const
+  {
+    if (row.weight == 0)
+    {
+      return this->entry_at(row.idx, i);
+    }
+    return ((this->entry_at(row.idx + 1, i) - this->entry_at(row.idx, i)) * row.weight) + this->entry_at(row.idx, i);
+  }
+  Fractional_t get_x_by_y(Row const &row, Fractional_t const y) const
   {
     int low = 0, high = number_of_intervals;
+    Fractional_t y_low = 0, y_high = 0;
   
     while (low <= high)
     {
       int mid = low + ((high - low) / 2);
+      Fractional_t const y_mid = this->get_y_by_row(row, mid);
   
-      if (ys[mid] > y)
+      if (y_mid > y)
       {
         high = mid - 1;
+        y_high = y_mid;
       }
-      else if (ys[mid] < y)
+      else if (y_mid < y)
       {
         low = mid + 1;
+        y_low = y_mid;
       }
       else
       {
@@ -216,36 +606,25 @@ public:
     }
     else
     {
-      return this->get_x_by_parameter(((y - ys[high]) / (ys[low] - ys[high])) * (low - high) + high);
+      return this->get_x_by_parameter(((y - y_low) / (y_high - y_low)) * (low - high) + high);
     } 
   }
-  Fractional_t with_s_get_x_by_y(Fractional_t const s, Fractional_t const y)
+  Fractional_t with_s_get_x_by_y(Fractional_t const s, Fractional_t const y) const
   {
-    if (s <= min_of_s)
-    {
-      for (int i = 0; i < TableWidth; i++)
-      {
-        ys[i] = table[0][i];
-      }
-    }
-    else if (s >= max_of_s)
-    {
-      for (int i = 0; i < TableWidth; i++)
-      {
-        ys[i] = table[number_of_s_levels][i];
-      }
-    }
-    else
-    {
-      Fractional_t const param_s = (s - min_of_s) * (number_of_s_levels / (max_of_s - min_of_s));
-      int const idx = param_s;
-      
-      for (int i = 0; i < TableWidth; i++)
-      {        
-        ys[i] = ((table[idx + 1][i] - table[idx][i]) * (param_s - idx)) + table[idx][i];
-      }
-    }
-    return this->get_x_by_y(y);
+    return this->get_x_by_y(this->get_row_by_s(s), y);
+  }
+private:
+  Fractional_t decode(Fractional_t const entry) const
+  {
+    return entry;
+  }
+  Fractional_t decode(uint16_t const code) const
+  {
+    return base_of_entries + unit_of_entries * code;
+  }
+  Fractional_t entry_at(int const idx, int const i) const
+  {
+    return this->decode(table_in_flash ? readFlash(&table[idx][i]) : table[idx][i]);
   }
 };
 /* Comments
@@ -263,24 +642,172 @@ public:
 ** - Guarantees
 **   [A] y = x^n
 **   [B] y >= 1
+** [CRC16]
+** 1. A function to calculate CRC-16/CCITT-FALSE (poly = 0x1021, init = 0xFFFF) of `bytes`.
+** 2. Passing the result as `crc` continues the calculation over the next bytes.
+** [clockMicros]
+** 1. A function to read the monotonic clock in microseconds, which is `micros` unless another source is set.
+** [setClockSource]
+** 1. A function to replace the source of `clockMicros`, e.g. by a virtual clock on the host.
+** 2. `time_source` must be monotonic modulo `2^32`, and it is called wherever `clockMicros` is.
+** [encodeU16]
+** 1. A function to encode `val` into a `uint16_t` code,
+**    such that `val` is approximately `base + unit * code`.
+** 2. Requirements
+**   [A] base =< val =< base + 65535 * unit
+** [readFlash]
+** 1. A function to read a value placed in the flash by `PROGMEM`.
+** [Unrolled]
+** 1. A class to unroll a loop of a constant number of iterations.
+** 2. Usage
+** > Unrolled<3>::forEach([&](int const i) { sum += xs[i]; });
+** - Guarantees
+**   [A] `job(0)`, `job(1)`, ..., `job(N - 1)` are called in order,
+**       each of which is inlined with a constant index.
 ** [Timer]
 ** 1. A class, which imitates hourglass.
+** 2. It keeps the beginning as a `us_t` of `clockMicros`,
+**    hence `Timer::getDuration` takes one 32-bit subtraction and is correct across a wrap-around.
+** 3. `Timer::time` and `Timer::getDuration` are in milliseconds, and `Timer::getMicros` is in microseconds.
+** - Requirements
+**   [A] Durations measured are shorter than `2^32[us]`, about 71 minutes.
+** [Task]
+** 1. A class, each instance of which is an entry of the table of `Scheduler`.
+** 2. `Task::job` is called every `Task::period` milliseconds.
+** 3. `Task::max_jitter` is the maximum lateness of starting `Task::job`,
+**    `Task::max_duration` is the maximum time spent in `Task::job`, and
+**    `Task::overruns` counts the periods which have been skipped.
+** 4. `Task::next_due`, `Task::max_jitter` and `Task::max_duration` are in microseconds of `clockMicros`.
+** 5. The statistics start from zero, and `Scheduler::start` clears them again.
+** [Scheduler]
+** 1. A cooperative multi-rate scheduler over a fixed table of `Task`s.
+** 2. `Scheduler::untilNextDue` returns the microseconds until the earliest deadline, or `0` if a task is due.
+** 3. `Scheduler::report` prints the statistics of one task by `slog`, taking the tasks in turn,
+**    so that a call fits the serial ring buffer. It returns `true` after the last task of the table.
+** 4. Usage
+** > Task tasks[] = { { .job = measure, .period = 10 }, { .job = display, .period = 500 } };
+** > Scheduler scheduler = { .tasks_ref = &tasks };
+** > scheduler.start(); // in `setup`
+** > scheduler.runOnce(); // in `loop`
+** - Guarantees
+**   [A] Due tasks are run in the order of the table.
+**   [B] Deadlines advance by `Task::period`, hence they do not drift.
+**   [C] The serial ring buffer is pumped whenever `Scheduler::runOnce` is called.
+**   [D] Deadlines are compared by the signed difference of `us_t`s, hence they survive a wrap-around of `clockMicros`.
+** - Requirements
+**   [A] Every `Task::period` is shorter than `2^31[us]`, about 35 minutes.
+** [Transition]
+** 1. A class, each instance of which is an entry of the table of `StateMachine`.
+** 2. In the state `Transition::from`, the event `Transition::event` moves to the state `Transition::to`,
+**    and then `Transition::action` is called unless it is `nullptr`.
+** [StateMachine]
+** 1. An event-driven state machine over a fixed table of `Transition`s.
+** 2. Usage
+** > Transition const transitions[] PROGMEM = { { .from = idle, .event = go, .to = busy, .action = start } };
+** > StateMachine machine = { .transitions_ref = &transitions, .init_state = idle, .in_flash = true };
+** > machine.raise(go); // whenever the event happens
+** - Guarantees
+**   [A] The first entry of the table matching the state and the event is taken, hence at most one per `StateMachine::raise`.
+**   [B] An event which has no entry in the current state is ignored, and `StateMachine::raise` returns `false`.
+**   [C] The state is changed before the action is called, hence the action may raise another event.
+** 3. `StateMachine::dump` prints every entry of the table as `from --event--> to` by `slog`,
+**    so that the graph can be checked without running the machine.
+**    The names are rows of `char` arrays placed by `PROGMEM`, indexed by the states and the events.
+** [CoulombCounter]
+** 1. A class, which integrates currents into a charge by the trapezoidal rule.
+** 2. Usage
+** > counter.reset(Q_0); // in mAh
+** > counter.integrate(clockMicros(), Iin, not discharger_pin.isHigh()); // for each sample
+** > Q = counter.get_mAh();
+** - Guarantees
+**   [A] `(I_0 + I_1) * (t_1 - t_0)` is accumulated exactly as twice the charge,
+**       since `1[mA] * 1[us] = 1[uAms]`, hence the charge does not drift by rounding.
+**   [B] The interval ending at a sample with `counting == false` is not accumulated.
+**   [C] The first sample after `CoulombCounter::reset` only opens an interval.
+** [EepromRing]
+** 1. A class, which keeps the latest record of `size_of_payload` bytes in a ring of slots in the EEPROM.
+** 2. Layout of a slot
+**    > seq (LE) | payload[size_of_payload] | crc16 (LE)
+**    where `crc16` is `CRC16` of `seq` and `payload`.
+** 3. Usage
+** > found = ring.load(&record); // once, before saving
+** > ring.save(&record); // stages a record, unless the last one is still being written
+** > ring.pump(); // frequently
+** - Guarantees
+**   [A] `EepromRing::load` returns the valid record of the newest `seq`.
+**   [B] Records are written into the slots in turn, hence the wear is spread over the ring.
+**   [C] `EepromRing::pump` writes at most one byte, and only if the EEPROM is ready,
+**       hence it never waits for the EEPROM.
+**   [D] If the power is lost while a record is being written,
+**       the CRC of the slot fails and the previous record remains the newest.
 ** [AscList]
 ** 1. A class to calculate the inverse of the strictly increasing function.
+** 2. If an index buffer is given, the range of `ys` is split into uniform buckets,
+**    each of which holds the first interval it overlaps,
+**    so that `AscList::get_x_by_y` needs one multiplication and a bracket check
+**    instead of the binary search.
+** 3. `AscList::get_slope_by_x` returns `dy/dx` of the interval containing `x`.
+** 4. If `in_flash` is `true`, `ys` must be placed in the flash by `PROGMEM`,
+**    and every entry is read by `readFlash`.
+** 5. `ys` may be given as `uint16_t` codes with `base` and `unit`,
+**    where the `i`-th entry is `base + unit * code[i]`.
+**    Then `AscList::get_x_by_y` converts `y` into a code once,
+**    the search compares the codes as integers,
+**    and the buckets of the index are uniform in codes instead of `ys`.
+**    The codes must be absolute, not deltas, since the search reads entries at random.
+** [EcmParameters]
+** 1. A class, each instance of which is a first-order RC equivalent-circuit model of a cell.
+** 2. `V = OCV(soc) + Vrc + R0 * I`, where `dVrc/dt = (R1 * I - Vrc) / tau`.
+** 3. Units are mAh, ohm and milliseconds; `var_of_*` are variances in percent^2 and volt^2,
+**    and `var_of_soc` and `var_of_Vrc` are added per millisecond of the prediction.
+** 4. `R0 + R1` is the resistance seen by the taps at a steady current, including the wires.
+** [SocEstimator]
+** 1. A class, which estimates the SOC of a cell by the extended Kalman filter on `EcmParameters`, which is experimental.
+** 2. Usage
+** > estimator.init(&mySocOcvTable, &myEcm); // once
+** > estimator.reset(soc_0, counter.get_uAms(), clockMicros()); // in percent
+** > estimator.update(counter.get_uAms(), clockMicros(), I, V, true); // for each control step
+** > soc = estimator.get_soc();
+** - Notes
+**   [A] The prediction takes the charge counted by `CoulombCounter` since the last update,
+**       hence no sample of the current is missed between the updates.
+**   [B] The measurement takes `OCV` and its slope from `ocv_table`,
+**       and it is skipped when `measuring == false`, e.g. while the bleed resistor is on.
+**   [C] Every operation is in `float`, which is single precision on AVR.
 ** [Map2d]
 ** 1. A class, which is equivalent to the class `AscList` with parameter `s`.
+** 2. Rows between two levels of `s` are interpolated lazily,
+**    i.e., only the entries visited by the binary search are interpolated.
+** 3. Usage
+** > row = myMap2d.get_row_by_s(s);
+** > x1 = myMap2d.get_x_by_y(row, y1);
+** > x2 = myMap2d.get_x_by_y(row, y2);
+** - Guarantees
+**   [A] x1 == myMap2d.with_s_get_x_by_y(s, y1)
+**   [B] x2 == myMap2d.with_s_get_x_by_y(s, y2)
+** - Notes
+**   [A] Keeping `row` for repeated queries at the same `s` skips the row work completely.
+**   [B] If `in_flash` is `true`, the table must be placed in the flash by `PROGMEM`.
+**   [C] If `Entry_t` is `uint16_t`, the entries are codes decoded by `base + unit * code` when they are read.
 */
 
 // implemented in "printers.cpp"
 LcdHandle_t openLcdI2C(int lcd_screen_width, int lcd_screen_height);
+void queueSerial(char const *str);
+void queueSerial(__FlashStringHelper const *str);
+void queueSerial(byte const *bytes, int len);
+void sealSerial();
+void pumpSerial();
+unsigned long droppedSerial();
 template <size_t Capacity>
 class SizedFormatter {
+  static constexpr int capacity = Capacity;
   int cnt = 0;
   char buf[Capacity] = { };
 public:
   void clear()
   {
-    for (cnt = 0; cnt < Capacity; cnt++)
+    for (cnt = 0; cnt < capacity; cnt++)
     {
       buf[cnt] = ' ';
     }
@@ -295,7 +822,7 @@ public:
   }
   void putChar(char const printMe)
   {
-    if (cnt < Capacity)
+    if (cnt < capacity)
     {
       buf[cnt++] = printMe;
     }
@@ -304,26 +831,19 @@ public:
   {
     if (printMe >= 0 && printMe < 16)
     {
-      this->putChar("0123456789ABCDEF"[printMe]);
+      this->putChar(digitOf(printMe));
     }
   }
   void putInt(BigInt_t const printMe, int const base)
   {
-    int cn = 0;
-    BigInt_t val = printMe;
-    if (val < 0)
+    int const radix = base < 2 ? 2 : base > 16 ? 16 : base;
+    uint64_t val = printMe;
+    if (printMe < 0)
     {
       this->putChar('-');
-      val *= -1;
-    }
-    for (BigInt_t _val = 1; _val <= val; _val *= base)
-    {
-      cn++;
+      val = 0 - val;
     }
-    do
-    {
-      this->putDigit(((base * val) / POW(base, cn)) % base);
-    } while (--cn > 0);
+    this->putUnsigned(val, radix, 1);
   }
   void putDouble(double const printMe, int const afters_dot)
   {
@@ -336,33 +856,41 @@ public:
     }
     if (afters_dot > 0)
     {
-      int cn = afters_dot;
-      BigInt_t pow10_afters_dot = POW(base, afters_dot);
-      BigInt_t valN = ROUND(val * pow10_afters_dot);
-      BigInt_t valF = valN % pow10_afters_dot;
-      valN /= pow10_afters_dot;
-      this->putInt(valN, base);
-      this->putChar('.');
-      do
+      uint64_t const pow10_afters_dot = POW(base, afters_dot);
+      uint64_t const valN = ROUND(val * pow10_afters_dot);
+      if (valN <= UINT32_MAX)
+      {
+        uint32_t const valN32 = valN;
+        uint32_t const pow10_afters_dot32 = pow10_afters_dot;
+        this->putDigits<uint32_t>(valN32 / pow10_afters_dot32, base, 1);
+        this->putChar('.');
+        this->putDigits<uint32_t>(valN32 % pow10_afters_dot32, base, afters_dot);
+      }
+      else
       {
-        this->putDigit(((base * valF) / POW(base, cn)) % base);
-      } while (--cn > 0);
+        this->putUnsigned(valN / pow10_afters_dot, base, 1);
+        this->putChar('.');
+        this->putUnsigned(valN % pow10_afters_dot, base, afters_dot);
+      }
     }
     else
     {
-      BigInt_t valE = POW(base, - afters_dot);
-      BigInt_t valN = ROUND(val / (static_cast<double>(valE)));
-      valN *= valE;
-      this->putInt(valN, base);
+      uint64_t const valE = POW(base, - afters_dot);
+      uint64_t const valN = ROUND(val / (static_cast<double>(valE)));
+      this->putUnsigned(valN * valE, base, 1);
     }
   }
+  int size() const
+  {
+    return cnt;
+  }
   void putString(char const *const printMe)
   {
     if (printMe)
     {
       for (char const *p_ch = printMe; *p_ch != '\0'; p_ch++)
       {
-        if (cnt < Capacity)
+        if (cnt < capacity)
         {
           buf[cnt++] = *p_ch;
         }
@@ -373,6 +901,52 @@ public:
       }
     }
   }
+  void putString(__FlashStringHelper const *const printMe)
+  {
+    if (printMe)
+    {
+      for (char const *p_ch = reinterpret_cast<char const *>(printMe); pgm_read_byte(p_ch) != '\0' && cnt < capacity; p_ch++)
+      {
+        buf[cnt++] = pgm_read_byte(p_ch);
+      }
+    }
+  }
+private:
+  static char digitOf(int const digit)
+  {
+    return digit < 10 ? '0' + digit : 'A' + (digit - 10);
+  }
+  template <typename Unsigned_t>
+  void putDigits(Unsigned_t val, Unsigned_t const base, int const min_len)
+  {
+    constexpr int capacity_of_digits = 8 * sizeof(Unsigned_t);
+    char digits[capacity_of_digits];
+    int len = 0;
+    do
+    {
+      digits[len++] = digitOf(val % base);
+      val /= base;
+    } while (val > 0 && len < capacity_of_digits);
+    while (len < min_len && len < capacity_of_digits)
+    {
+      digits[len++] = '0';
+    }
+    while (len > 0)
+    {
+      this->putChar(digits[--len]);
+    }
+  }
+  void putUnsigned(uint64_t const val, int const base, int const min_len)
+  {
+    if (val <= UINT32_MAX)
+    {
+      this->putDigits<uint32_t>(val, base, min_len);
+    }
+    else
+    {
+      this->putDigits<uint64_t>(val, base, min_len);
+    }
+  }
 };
 class LcdPrinter {
   LcdHandle_t const lcdHandle;
@@ -396,25 +970,43 @@ public:
   void println(double val, int afters_dot = 2);
   void print(char const *str);
   void println(char const *str);
+  void print(__FlashStringHelper const *str);
+  void println(__FlashStringHelper const *str);
 };
 class SerialPrinter {
-  char const *const prefix_of_message;
+  __FlashStringHelper const *const prefix_of_message;
   bool newline;
 public:
   SerialPrinter() = delete;
   SerialPrinter(SerialPrinter const &other) = delete;
   SerialPrinter(SerialPrinter &&other);
-  SerialPrinter(char const *prefix);
-  SerialPrinter(char const *prefix, bool lend);
+  SerialPrinter(__FlashStringHelper const *prefix);
+  SerialPrinter(__FlashStringHelper const *prefix, bool lend);
   ~SerialPrinter();
   void trick();
   SerialPrinter operator<<(bool is);
   SerialPrinter operator<<(byte hex);
   SerialPrinter operator<<(int num);
   SerialPrinter operator<<(char const *str);
+  SerialPrinter operator<<(__FlashStringHelper const *str);
   SerialPrinter operator<<(double val);
 };
 extern SerialPrinter sout, serr, slog;
+class TelemetryFrame {
+  byte payload[TELEMETRY_LEN_MAX];
+  int cnt;
+public:
+  TelemetryFrame() = delete;
+  TelemetryFrame(TelemetryFrame const &other) = delete;
+  TelemetryFrame(TelemetryFrame &&other) = delete;
+  TelemetryFrame(byte type);
+  ~TelemetryFrame();
+  void putU8(uint8_t val);
+  void putI16(int16_t val);
+  void putU16(uint16_t val);
+  void putI32(int32_t val);
+  void putU32(uint32_t val);
+};
 /* Comments
 ** [openLcdI2C]
 ** 1. Usage
@@ -440,20 +1032,57 @@ extern SerialPrinter sout, serr, slog;
 ** 2. References
 **    [1] https://codingrun.com/119
 **    [2] https://m.blog.naver.com/hy10101010/221562445464
+** [queueSerial]
+** 1. A function to put a string, or `len` bytes, into the serial ring buffer.
+** 2. A string given as `__FlashStringHelper const *`, e.g. by `F("...")`, is read from the flash.
+** 3. It never waits for the serial port.
+** 4. The characters are a part of a message until the message is sealed;
+**    a string seals the message at every `'\n'`, but bytes never do.
+** [sealSerial]
+** 1. A function to end the message being queued.
+** [pumpSerial]
+** 1. A function to move characters from the serial ring buffer to the serial port,
+**    as many as the port can accept without blocking.
+** 2. A message is sent only after it is sealed.
+** [droppedSerial]
+** 1. A function returning the number of messages discarded by `SERIAL_OVERFLOW`.
+** 2. A message is discarded as a whole, so the port never sends a part of a message.
 ** [SizedFormatter]
 ** 1. A class, which helps the class `LcdPrinter`.
+** 2. Digits are filled in reverse order into a local buffer,
+**    with 32-bit arithmetic whenever the value fits in `uint32_t`.
+** 3. `SizedFormatter::putInt` clamps `base` into [2, 16].
 ** [LcdPrinter]
 ** 1. A class, whose destructor prints contents in the screen.
+** 2. A shadow of the screen is kept per handle, for up to `LCD_SHADOWS_MAX` handles,
+**    so that only the changed runs of characters are sent through I2C.
+**    A handle beyond them takes the slot of the oldest one, whose screen is cleared when it is printed next.
+** 3. If the screen is manipulated through the handle directly,
+**    the shadow is reset by `openLcdI2C` or `LcdPrinter::clear`.
+** 4. `LcdPrinter::print` and `LcdPrinter::println` take literals by `F("...")` as well.
 ** [SerialPrinter]
 ** 1. A class, which is similar to `std::ostream` of C++.
 ** 2. But the major difference is that line breaks in this class become `;`.
 **    This feature is carried out by `SerialPrinter::~SerialPrinter` and `SerialPrinter::trick`.
+** 3. Messages are queued by `queueSerial` and drained by `pumpSerial`,
+**    hence printing never stalls the control loop.
+** 4. Literals should be given by `F("...")`, which leaves them in the flash instead of the SRAM on AVR;
+**    the prefixes of `sout`, `serr` and `slog` are in the flash as well.
 ** [sout]
 ** 1. `sout` stands for serial output.
 ** [serr]
 ** 1. `serr` stands for serial error.
 ** [slog]
 ** 1. `slog` stands for serial logger.
+** [TelemetryFrame]
+** 1. A class, whose destructor queues a binary frame into the serial ring buffer.
+** 2. Layout of a frame
+**    > 0xA5 0x5A | len | type | payload[len - 1] | crc16 (LE)
+**    where `crc16` is `CRC16` of `len`, `type` and `payload`,
+**    and every multi-byte field is little-endian.
+** 3. Text lines may be interleaved between frames;
+**    a decoder resynchronizes on `0xA5 0x5A` and a valid `crc16`.
+** 4. "host/telemetry2csv.cpp" decodes frames into CSV.
 */
 
 // implemented in "pinhandlers.cpp"
@@ -461,17 +1090,41 @@ struct PinHandler {
   pinId_t const pin_to_handle;
 };
 class PinReader : public PinHandler {
+  friend class TripGuard;
+  friend void beginAdcSampler();
+  friend void holdAdcWindows();
+  int volatile last_signal;
+  uint32_t volatile sum_of_window;
+  uint16_t volatile cnt_of_window;
+  uint32_t volatile sum_of_last_window;
+  uint16_t volatile cnt_of_last_window;
+  uint32_t sum_of_held_window;
+  uint16_t cnt_of_held_window;
+  uint32_t volatile sum_of_sq_diffs;
+  uint16_t volatile variance;
+  uint8_t volatile window_shift;
+  uint16_t const target_variance;
 public:
   PinReader() = delete;
   PinReader(PinReader const &other) = delete;
   PinReader(PinReader &&other) = delete;
-  PinReader(pinId_t pinId);
+  PinReader(pinId_t pinId, Sig_t target_error = ADC_TARGET_ERROR);
   ~PinReader();
   int readSignalOnce() const;
   Val_t readSignal(ms_t duration) const;
+  Sig_t readSignalFixed(ms_t duration) const;
+  uint16_t getWindowLength() const;
+  uint16_t getVariance() const;
+  bool takeSample(int signal, uint16_t round);
+private:
+  void adaptWindow();
+  bool takeWindow(uint32_t &sum, uint16_t &cnt) const;
+  uint16_t collectSignal(ms_t duration, uint32_t &sum) const;
 };
 class PinSetter : public PinHandler {
   bool volatile is_high;
+  friend class PinGroup;
+  friend class TripGuard;
 public:
   PinSetter() = delete;
   PinSetter(PinSetter const &other) = delete;
@@ -496,16 +1149,213 @@ public:
   void init() const;
   void set(double duty_ratio) const;
 };
+class PinGroup {
+  PinSetter *const pins;
+  int const number_of_pins;
+  uint16_t wanted_bits;
+  uint16_t staged_bits;
+public:
+  PinGroup() = delete;
+  PinGroup(PinGroup const &other) = delete;
+  PinGroup(PinGroup &&other) = delete;
+  template <size_t number_of_pins_in_group>
+  PinGroup(PinSetter (*const pins_ref)[number_of_pins_in_group])
+    : pins{ *pins_ref }
+    , number_of_pins{ static_cast<int>(number_of_pins_in_group) }
+    , wanted_bits{ 0 }
+    , staged_bits{ 0 }
+  {
+    static_assert(number_of_pins_in_group <= PIN_GROUP_MAX, "`PinGroup` holds the wanted states as `uint16_t`.");
+  }
+  ~PinGroup();
+  void set(int pin_no, bool be_high);
+  void commit();
+};
+struct TripLimit {
+  PinReader const *plus;
+  PinReader const *minus;
+  int lo;
+  int hi;
+  uint8_t strikes;
+};
+class TripGuard {
+  TripLimit *const limits;
+  int const number_of_limits;
+  PinSetter *const breaker;
+  uint8_t volatile fault_code;
+public:
+  static constexpr int no_limit = 32767;
+  TripGuard() = delete;
+  TripGuard(TripGuard const &other) = delete;
+  TripGuard(TripGuard &&other) = delete;
+  template <size_t number_of_limits_in_table>
+  TripGuard(TripLimit (*const limits_ref)[number_of_limits_in_table], PinSetter *const breaker_ref)
+    : limits{ *limits_ref }
+    , number_of_limits{ static_cast<int>(number_of_limits_in_table) }
+    , breaker{ breaker_ref }
+    , fault_code{ 0 }
+  {
+    static_assert(number_of_limits_in_table < 16, "`TripGuard` keeps the index of a limit in 4 bits of the fault code.");
+  }
+  ~TripGuard();
+  void watch(int limit_no, PinReader const *plus, PinReader const *minus);
+  void setLimits(int limit_no, int lo, int hi);
+  void arm();
+  void disarm();
+  void check(PinReader const *sampled);
+  uint8_t getFault() const;
+  void clear();
+private:
+  void trip(uint8_t code);
+};
+template <pinId_t... Pins>
+struct PinList {
+  static constexpr int size = sizeof...(Pins);
+};
+template <typename ReaderPins, typename DischargerPins>
+class PackTopology;
+template <pinId_t... ReaderPins, pinId_t... DischargerPins>
+class PackTopology<PinList<ReaderPins...>, PinList<DischargerPins...>> {
+public:
+  static constexpr int number_of_cells = sizeof...(ReaderPins);
+  PinReader READER_pins[number_of_cells];
+  PinSetter DISCHARGER_pins[number_of_cells];
+  PackTopology()
+    : READER_pins{ { ReaderPins }... }
+    , DISCHARGER_pins{ { DischargerPins }... }
+  {
+    static_assert(sizeof...(ReaderPins) == sizeof...(DischargerPins), "Every cell needs a reader pin and a discharger pin.");
+    static_assert(sizeof...(ReaderPins) > 0, "A pack needs at least one cell.");
+  }
+  PackTopology(PackTopology const &other) = delete;
+  PackTopology(PackTopology &&other) = delete;
+  ~PackTopology()
+  {
+  }
+  template <typename Job>
+  static inline void forEachCell(Job const &job)
+  {
+    Unrolled<number_of_cells>::forEach(job);
+  }
+};
+void beginAdcSampler();
+void endAdcSampler();
+bool isAdcSamplerRunning();
+uint16_t countAdcScans();
+void holdAdcWindows();
+void releaseAdcWindows();
 /* Comments
 ** [PinHandler]
 ** 1. The base class of pin-handling classes.
 ** 2. Its instances consist of a pin to contol.
 ** [PinReader]
 ** 1. A class, read analog signal from the sensor.
+** 2. Every instance registers itself to the ADC sampler on construction, and unregisters itself on destruction.
+**    An instance beyond `ADC_READERS_MAX` is not registered, which `beginAdcSampler` reports through `serr`.
+** 3. While the ADC sampler is running,
+**    `PinReader::readSignal` returns the average of the last window at once,
+**    or of the window held by `holdAdcWindows` until `releaseAdcWindows`,
+**    and `PinReader::readSignalOnce` returns the last sample.
+** 4. `PinReader::readSignalFixed` is the integer version of `PinReader::readSignal`.
+** 5. `PinReader::takeSample` is called by the ADC sampler only, and it returns `true` if the sample completes a window.
+** 6. The length of a window adapts to the noise of the channel while the ADC sampler is running.
+**    `PinReader::getVariance` returns the running variance of a sample in units of `1 / 256` counts^2,
+**    and `PinReader::getWindowLength` returns the number of samples of the next window,
+**    which is the least power of 2 in [`ADC_WINDOW_MIN`, `ADC_WINDOW_MAX`]
+**    whose standard error of the average does not exceed `target_error` in units of `Sig_t`.
+** - Guarantees
+**   [A] The variance is estimated by the mean square of the differences of successive samples over 2,
+**       which ignores the slow drift of the signal, e.g. of a cell being charged.
+**   [B] A window of `2^k` samples ends when the number of the rounds of the sampler is a multiple of `2^k`,
+**       hence every window ends together with the windows of the other channels which are not longer than it.
+** - Requirements
+**   [A] `target_error < 256`.
 ** [PinSetter]
 ** 1. A class, make the pin send digital signal. 
 ** [PwmSetter]
 ** 1. A class, make the pin send PWM-wave. 
+** [PinGroup]
+** 1. A class, which switches a group of `PinSetter`s at once.
+** 2. Usage
+** > PinGroup dischargers = { .pins_ref = &pack.DISCHARGER_pins };
+** > dischargers.set(0, true); // only staged
+** > dischargers.set(1, false); // only staged
+** > dischargers.commit();
+** - Guarantees
+**   [A] On AVR, the pins on the same port are switched by a single masked write of `PORTx` with interrupts disabled.
+**       Otherwise, `digitalWrite` is called for each changed pin.
+**   [B] Only the staged pins whose states are changed are written and logged.
+** - Notes
+**   [A] Calling `PinSetter::turnOn` or `PinSetter::turnOff` on a member is still allowed;
+**       `PinGroup::commit` compares the staged states with `PinSetter::isHigh`.
+** [PinList]
+** 1. A list of pins given as template arguments.
+** [PackTopology]
+** 1. A class, which describes a series pack by the pins of its cells at compile time.
+** 2. Usage
+** > typedef PackTopology<PinList<Apin(1), Apin(2)>, PinList<Dpin(2), Dpin(3)>> Pack;
+** > Pack pack;
+** > Pack::forEachCell([&](int const cell_no) { pack.DISCHARGER_pins[cell_no].turnOff(); });
+** - Guarantees
+**   [A] `READER_pins[i]` and `DISCHARGER_pins[i]` belong to the `i`-th cell from the bottom of the pack.
+**   [B] `PackTopology::forEachCell` is unrolled by `Unrolled<number_of_cells>`.
+** [TripLimit]
+** 1. A class, each instance of which is an entry of the table of `TripGuard`.
+** 2. The limit is violated if the last sample of `plus`, minus that of `minus` unless it is `nullptr`,
+**    is below `lo` or above `hi`, in counts of the ADC.
+** 3. `strikes` counts the consecutive violating samples of `plus`.
+** [TripGuard]
+** 1. A class, which opens `breaker` from the ADC sampler as soon as a limit is violated.
+** 2. Usage
+** > TripLimit limits[2];
+** > TripGuard guard = { .limits_ref = &limits, .breaker_ref = &powerIn_pin };
+** > guard.watch(0, &tap_pin, nullptr); // once, the limits are off
+** > guard.arm(); // once
+** > guard.setLimits(0, lo, hi); // whenever the reference changes
+** > if (guard.getFault() != 0) { ... } // in the main loop
+** - Guarantees
+**   [A] `TripGuard::check` is called by the conversion-complete interrupt after every sample,
+**       and it opens `breaker` once a limit is violated by `TRIP_STRIKES` consecutive samples of its `plus`,
+**       hence within `TRIP_STRIKES` rounds of the ADC sampler after the limit is crossed.
+**   [B] `breaker` is opened by a single write of `PORTx` on AVR, which neither waits nor logs.
+**   [C] The fault code is latched until `TripGuard::clear`, and no further limit is checked meanwhile.
+**       `0x10 | limit_no` stands for the violation of `hi`, and `0x20 | limit_no` for that of `lo`.
+** - Requirements
+**   [A] The ADC sampler is running; otherwise, nothing is checked.
+**   [B] `TripGuard::setLimits` is called only after every watched `PinReader` has been sampled,
+**       since the difference of a stale sample might trip `breaker`.
+** [beginAdcSampler]
+** 1. A function to start the interrupt-driven ADC sampler.
+** 2. The conversion-complete interrupt cycles through every registered `PinReader` in the order of registration,
+**    accumulating `ADC_WINDOW_LEN` samples per window,
+**    and then it calls `TripGuard::check` of the armed guard.
+** 3. `analogRead` must not be called while the sampler is running.
+** 4. The sampler is built wherever `ADC_vect` is defined, i.e. on AVR and on the host simulation.
+** - Guarantees
+**   [A] The interrupt starts the conversion of the next channel before it processes the current sample,
+**       hence the processing overlaps the conversion instead of delaying it.
+**   [B] The windows of every `PinReader` are restarted together with the count of rounds,
+**       after the last sample of each one is primed by `analogRead`.
+** [endAdcSampler]
+** 1. A function to stop the ADC sampler.
+** [isAdcSamplerRunning]
+** 1. A function to check whether the ADC sampler is running.
+** [countAdcScans]
+** 1. A function which returns the number of the windows completed by any `PinReader`, modulo 2^16.
+** [holdAdcWindows]
+** 1. A function which copies the last window of every registered `PinReader` in a single critical section,
+**    so that the readings until `releaseAdcWindows` are taken at the same instant.
+** 2. Usage
+** > holdAdcWindows();
+** > ... // `PinReader::readSignal` of every reader returns its held window
+** > releaseAdcWindows();
+** - Guarantees
+**   [A] The held windows are the last ones completed before a single instant, and none changes until `releaseAdcWindows`.
+**       They may differ in length, and a shorter window may end at a later round than a longer one,
+**       by `PinReader` Guarantee [B].
+**   [B] A `PinReader` without a completed window is read as if nothing were held.
+** [releaseAdcWindows]
+** 1. A function which makes `PinReader::readSignal` return the last window again.
 */
 
 // implemented in "data.cpp"
@@ -535,9 +1385,27 @@ struct ReferenceCollection {
   Ohm_t const sensitivityOfCurrentSensor;
   Vol_t const zenerdiodeVfromRtoA;
 };
+template <int NumberOfCells>
+struct CellStates {
+  mV_t cellVs[NumberOfCells];
+  mV_t cellVs_measured[NumberOfCells];
+  mV_t cellVs_calibration[NumberOfCells];
+  mV_t cellVs_calibration2[NumberOfCells];
+  mAh_t Qs[NumberOfCells];
+  CoulombCounter Qs_counters[NumberOfCells];
+#if SOC_ESTIMATOR == SOC_EKF
+  EcmParameters ecms[NumberOfCells];
+  SocEstimator socEstimators[NumberOfCells];
+#endif
+};
 /* Comments
 ** [ReferenceCollection]
 ** 1. A class, each instance of which is a collection of value references.
+** [CellStates]
+** 1. A class, which holds every per-cell value of `BMS` as a struct of arrays,
+**    so that the arrays are sized by `PackTopology::number_of_cells` together.
+** 2. `ecms` are the parameters of each cell, which `socEstimators` point to,
+**    since the capacities and the resistances of the cells differ.
 */
 
 #endif
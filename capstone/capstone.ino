@@ -19,6 +19,57 @@ ReferenceCollection const refOf =
 , .zenerdiodeVfromRtoA          = 2.48
 };
 
+static constexpr
+Ohm_t R1 = 18000.0, R2 = 2000.0;
+
+static constexpr
+int signalShift = 10 + ADC_FRACTION_BITS;
+
+static constexpr
+uint32_t arduino5V_numerator = ROUND(1000.0 * refOf.zenerdiodeVfromRtoA * (1L << signalShift));
+
+static constexpr
+int32_t dividerGainQ8 = ROUND(256.0 * (R1 + R2) / R2), currentGainQ8 = ROUND(256.0 / refOf.sensitivityOfCurrentSensor);
+
+static_assert(refOf.analogSignalMax == (1L << 10), "`signalShift` assumes a 10-bit ADC.");
+static_assert(dividerGainQ8 < 3200 && currentGainQ8 < 3200, "`scaleSignal` would overflow.");
+
+static inline
+mV_t arduino5VOf(Sig_t const zener_signal)
+{
+  return zener_signal > 0 ? arduino5V_numerator / zener_signal : 0;
+}
+
+static inline
+int32_t scaleSignal(mV_t const ref_mV, int32_t const signal, int32_t const gainQ8)
+{
+  return (((ref_mV * signal) >> 7) * gainQ8) >> (signalShift + 8 - 7);
+}
+
+static inline
+mV_t tapVOf(mV_t const arduino5V_mV, Sig_t const signal)
+{
+  return scaleSignal(arduino5V_mV, signal, dividerGainQ8);
+}
+
+static inline
+mA_t IinOf(mV_t const arduino5V_mV, Sig_t const signal)
+{
+  return scaleSignal(arduino5V_mV, static_cast<int32_t>(signal) - (1L << (signalShift - 1)), currentGainQ8);
+}
+
+static inline
+int tapCountsOf(mV_t const arduino5V_mV, mV_t const tapV)
+{
+  return arduino5V_mV > 0 ? (static_cast<int32_t>(tapV) << 18) / (arduino5V_mV * dividerGainQ8) : TripGuard::no_limit;
+}
+
+static inline
+int IinCountsOf(mV_t const arduino5V_mV, mA_t const Iin_sensor)
+{
+  return arduino5V_mV > 0 ? (1 << 9) + (static_cast<int32_t>(Iin_sensor) << 18) / (arduino5V_mV * currentGainQ8) : TripGuard::no_limit;
+}
+
 #if MAJOR_VERSION <= 1
 
 struct PinsOfCell {
@@ -74,13 +125,13 @@ class BMS {
   PinReader Iin_pin       = { .pinId = Apin(3) };
   PinSetter powerIn_pin   = { .pinId = Dpin(13) };
 #endif
-  Timer Qs_lastUpdatedTime      = { .init_time = 0 };
   LcdHandle_t lcd_handle        = nullptr;
   Vol_t arduino5V               = refOf.arduinoRegularV;
   Amp_t Iin                     = 0.00;
   Amp_t Iin_calibration         = 0.00;
   Vol_t cellVs[LENGTH(cells)]   = { };
   mAh_t Qs[LENGTH(cells)]       = { };
+  CoulombCounter Qs_counters[LENGTH(cells)];
   BitArray<byte> bms_state      = 0u;
   int8_t dormant_cnt            = 0;
 public:
@@ -100,7 +151,7 @@ public:
   void unlockCells();
   void unlockPower();
   void greeting();
-  void goodbye(char const *bye_message, int seconds_left_to_quit = 10);
+  void goodbye(__FlashStringHelper const *bye_message, int seconds_left_to_quit = 10);
   void report() const;
   void revive();
 } myBMS;
@@ -119,7 +170,7 @@ void BMS::setup()
 {
   Timer hourglass = { };
   invokingSerial();
-  sout << "Runtime begin.";
+  sout << F("Runtime begin.");
   bms_state = 0u;
   dormant_cnt = 0;
   bms_state.set(bms_life, true);
@@ -132,6 +183,7 @@ void BMS::setup()
   bms_state.set(cells_locked, true);
   powerIn_pin.initWith(false);  
   bms_state.set(power_locked, true);
+  beginAdcSampler();
   lcd_handle = openLcdI2C(LCD_WIDTH, LCD_HEIGHT);
   this->init();
   this->greeting();
@@ -170,8 +222,8 @@ void BMS::loop()
     okay &= bms_state.get(not_dormant);
     if (bms_state.get(jobs_finished))
     {
-      sout << "CHARGING COMPLETED.";
-      this->goodbye("JOBS FINISHED");
+      sout << F("CHARGING COMPLETED.");
+      this->goodbye(F("JOBS FINISHED"));
       break;
     }
     okay &= this->checkCellsAttatched();
@@ -180,7 +232,7 @@ void BMS::loop()
     {
       if (bms_state.get(bms_being_operating))
       {
-        sout << "Running.";
+        sout << F("Running.");
         this->routine();
         break;
       }
@@ -190,9 +242,9 @@ void BMS::loop()
         if (lcd_handle)
         {
           LcdPrinter lcd = { .lcdHandleRef = lcd_handle };
-          lcd.println("ALL CELL");
-          lcd.println("S ARE RE");
-          lcd.println("COGNIZED");
+          lcd.println(F("ALL CELL"));
+          lcd.println(F("S ARE RE"));
+          lcd.println(F("COGNIZED"));
         }
         break;
       }
@@ -204,22 +256,22 @@ void BMS::loop()
           LcdPrinter lcd = { .lcdHandleRef = lcd_handle };
           for (int i = 0; i < LENGTH(cellVs); i++)
           {
-            lcd.print("B");
+            lcd.print(F("B"));
             lcd.print(i + 1);
-            lcd.print("=");
+            lcd.print(F("="));
             lcd.println(cellVs[i]);
-            lcd.print(" ");
+            lcd.print(F(" "));
             lcd.print(getSocOf(i));
-            lcd.println("%");
+            lcd.println(F("%"));
           }
-          lcd.println("TURN ON ");
-          lcd.println("POWER   ");
+          lcd.println(F("TURN ON "));
+          lcd.println(F("POWER   "));
         }
         this->unlockPower();
         for (int i = 0; i < LENGTH(cellVs); i++)
         {
-          sout << "cellVs[" << i << "] = " << cellVs[i] << "[V].";
-          sout << "soc[" << i << "] = " << getSocOf(i) << "%.";
+          sout << F("cellVs[") << i << F("] = ") << cellVs[i] << F("[V].");
+          sout << F("soc[") << i << F("] = ") << getSocOf(i) << F("%.");
         }
         break;
       }
@@ -238,30 +290,30 @@ void BMS::loop()
           LcdPrinter lcd = { .lcdHandleRef = lcd_handle };
           for (int i = 0; i < LENGTH(cellVs); i++)
           {
-            lcd.print("B");
+            lcd.print(F("B"));
             lcd.print(i + 1);
-            lcd.print("=");
+            lcd.print(F("="));
             lcd.println(cellVs[i]);
-            lcd.print(" ");
+            lcd.print(F(" "));
             lcd.print(getSocOf(i));
-            lcd.println("%");
+            lcd.println(F("%"));
           }
-          lcd.println("NO POWER");
-          lcd.println(" SUPPLY ");
+          lcd.println(F("NO POWER"));
+          lcd.println(F(" SUPPLY "));
         }
       }
       break;
   case false:
-      sout << "Runtime begin.";
+      sout << F("Runtime begin.");
       this->revive();
     }
     else
     {
       for (int i = 0; i < LENGTH(cellVs); i++)
       {
-        sout << "cellVs[" << i << "] = " << cellVs[i] << "[V].";
+        sout << F("cellVs[") << i << F("] = ") << cellVs[i] << F("[V].");
       }
-      sout << "Restarting.";
+      sout << F("Restarting.");
     }
     this->init();
     this->greeting();
@@ -287,27 +339,24 @@ bool BMS::routine()
 
 bool BMS::checkPowerConnected()
 {
-  Vol_t Vref_sensorV = refOf.zenerdiodeVfromRtoA, Vref = refOf.arduinoRegularV, Iin_sensorV = 0.5 * Vref;
-  Vref_sensorV = refOf.arduinoRegularV * arduino5V_pin.readSignal(20) / refOf.analogSignalMax;
-  Vref = refOf.arduinoRegularV * refOf.zenerdiodeVfromRtoA / Vref_sensorV;
-  Iin_sensorV = Vref * Iin_pin.readSignal(20) / refOf.analogSignalMax;
-  bms_state.set(power_connected, ((Iin_sensorV - 0.5 * Vref) / refOf.sensitivityOfCurrentSensor) >= allowedA_min);
+  mV_t const Vref = arduino5VOf(arduino5V_pin.readSignalFixed(20));
+  mA_t const Iin_sensorA = IinOf(Vref, Iin_pin.readSignalFixed(20));
+  bms_state.set(power_connected, Iin_sensorA >= ROUND(1000.0 * allowedA_min));
   return bms_state.get(power_connected);
 }
 
 bool BMS::checkCellsAttatched()
 {
   bool every_cell_being_attatched = true;
-  Vol_t sensorV = 0.0, accumV = 0.00;
-  double signal = 0.0;
+  mV_t tapV = 0, accumV = 0;
+  Sig_t signal = 0;
   for (int i = 0; i < LENGTH(cells); i++)
   {
-    constexpr Ohm_t R1 = 18000.0, R2 = 2000.0;
-    signal = cells[i].voltage_sensor_pin.readSignal(20);
-    sout << "signal (cell_no = " << i + 1 << ") = " << signal;
-    sensorV = refOf.arduinoRegularV * signal / refOf.analogSignalMax;
-    cellVs[i] = (sensorV / (R2 / (R1 + R2))) - accumV;
-    accumV += cellVs[i];
+    signal = cells[i].voltage_sensor_pin.readSignalFixed(20);
+    sout << F("signal (cell_no = ") << i + 1 << F(") = ") << static_cast<int>(signal >> ADC_FRACTION_BITS);
+    tapV = tapVOf(ROUND(1000.0 * refOf.arduinoRegularV), signal);
+    cellVs[i] = (tapV - accumV) / 1000.0;
+    accumV = tapV;
   }
   for (int i = 0; i < LENGTH(cellVs); i++)
   {
@@ -319,21 +368,19 @@ bool BMS::checkCellsAttatched()
 
 void BMS::measureValues()
 {
-  Vol_t sensorV = 0.00, accumV = 0.00;
+  mV_t tapV = 0, accumV = 0;
   // Calculate the voltage of the pin `5V`
-  sensorV = refOf.arduinoRegularV * arduino5V_pin.readSignal(10) / refOf.analogSignalMax;
-  arduino5V = refOf.arduinoRegularV * refOf.zenerdiodeVfromRtoA / sensorV;
+  mV_t const arduino5V_mV = arduino5VOf(arduino5V_pin.readSignalFixed(10));
+  arduino5V = arduino5V_mV / 1000.0;
   // Calculate the voltages of every cell
   for (int i = 0; i < LENGTH(cells); i++)
   {
-    constexpr Ohm_t R1 = 18000.0, R2 = 2000.0;
-    sensorV = arduino5V * cells[i].voltage_sensor_pin.readSignal(10) / refOf.analogSignalMax;
-    cellVs[i] = (sensorV / (R2 / (R1 + R2))) - accumV;
-    accumV += cellVs[i];
+    tapV = tapVOf(arduino5V_mV, cells[i].voltage_sensor_pin.readSignalFixed(10));
+    cellVs[i] = (tapV - accumV) / 1000.0;
+    accumV = tapV;
   }
   // Calculate the main current
-  sensorV = arduino5V * Iin_pin.readSignal(5) / refOf.analogSignalMax;
-  Iin = ((sensorV - 0.5 * arduino5V) / refOf.sensitivityOfCurrentSensor) - Iin_calibration;
+  Iin = (IinOf(arduino5V_mV, Iin_pin.readSignalFixed(5)) / 1000.0) - Iin_calibration;
 }
 
 void BMS::findQs_0()
@@ -341,20 +388,19 @@ void BMS::findQs_0()
   for (int cell_no = 0; cell_no < LENGTH(Qs); cell_no++)
   {
     Qs[cell_no] = refOf.batteryCapacity * mySocOcvTable.get_x_by_y(cellVs[cell_no]) / 100.0;
+    Qs_counters[cell_no].reset(Qs[cell_no]);
   }
-  Qs_lastUpdatedTime.reset();
 }
 
 void BMS::updateQs()
 {
+  us_t const now = clockMicros();
+
   for (int cell_no = 0; cell_no < LENGTH(cells); cell_no++)
   {
-    if (not cells[cell_no].BalanceCircuit_pin.isHigh())
-    {
-      Qs[cell_no] += Iin * Qs_lastUpdatedTime.getDuration() / 3600.0;
-    }
+    Qs_counters[cell_no].integrate(now, static_cast<mA_t>(1000.0 * Iin), not cells[cell_no].BalanceCircuit_pin.isHigh());
+    Qs[cell_no] = Qs_counters[cell_no].get_mAh();
   }
-  Qs_lastUpdatedTime.reset();
 }
 
 double BMS::getSocOf(int const cell_no) const
@@ -364,11 +410,11 @@ double BMS::getSocOf(int const cell_no) const
 
 void BMS::printValues() const
 {
-  sout << "arduino5V = " << arduino5V << "[V].";
-  sout << "Iin = " << Iin << "[A].";
+  sout << F("arduino5V = ") << arduino5V << F("[V].");
+  sout << F("Iin = ") << Iin << F("[A].");
   for (int i = 0; i < LENGTH(cellVs); i++)
   {
-    sout << "cellVs[" << i << "] = " << cellVs[i] << "[V].";
+    sout << F("cellVs[") << i << F("] = ") << cellVs[i] << F("[V].");
   }
   if (lcd_handle)
   {
@@ -376,16 +422,16 @@ void BMS::printValues() const
     for (int i = 0; i < LENGTH(cellVs); i++)
     {
       double const soc = getSocOf(i);
-      lcd.print("B");
+      lcd.print(F("B"));
       lcd.print(i + 1);
-      lcd.print("=");
+      lcd.print(F("="));
       lcd.println(cellVs[i]);
-      lcd.print(" ");
+      lcd.print(F(" "));
       lcd.print(soc);
-      lcd.println("%");
+      lcd.println(F("%"));
     }
-    lcd.print("I");
-    lcd.print("=");
+    lcd.print(F("I"));
+    lcd.print(F("="));
     lcd.println(Iin);
   }
 }
@@ -431,15 +477,15 @@ void BMS::greeting()
   if (lcd_handle)
   {
     LcdPrinter lcd = { .lcdHandleRef = lcd_handle };
-    lcd.println("> SYSTEM");
-    lcd.println(" ONLINE");
-    lcd.println("VERSION");
-    lcd.print("= ");
+    lcd.println(F("> SYSTEM"));
+    lcd.println(F(" ONLINE"));
+    lcd.println(F("VERSION"));
+    lcd.print(F("= "));
     lcd.println(VERSION);
   }
 }
 
-void BMS::goodbye(char const *const msg, int const countDown)
+void BMS::goodbye(__FlashStringHelper const *const msg, int const countDown)
 {
   Timer hourglass = { };
   this->lockCells();
@@ -450,7 +496,7 @@ void BMS::goodbye(char const *const msg, int const countDown)
     lcd_handle->setCursor(0, 1);
     lcd_handle->print(msg);
     lcd_handle->setCursor(1, 0);
-    lcd_handle->print(" SECS LEFT");
+    lcd_handle->print(F(" SECS LEFT"));
   }
   for (int i = countDown; i > 0; i--)
   {
@@ -459,7 +505,7 @@ void BMS::goodbye(char const *const msg, int const countDown)
       lcd_handle->setCursor(0, 0);
       lcd_handle->print(i - 1);
     }
-    serr << "Your arduino will abort in " << i << " seconds.";
+    serr << F("Your arduino will abort in ") << i << F(" seconds.");
     hourglass.delay(1000);
     hourglass.reset();
   }
@@ -470,7 +516,9 @@ void BMS::goodbye(char const *const msg, int const countDown)
     delete lcd_handle;
     lcd_handle = nullptr;
   }
+  endAdcSampler();
   Wire.end();
+  pumpSerial();
   Serial.end();
   this->lockPower();
   bms_state.set(bms_life, false);
@@ -480,16 +528,16 @@ void BMS::goodbye(char const *const msg, int const countDown)
 void BMS::report() const
 {
   drawlineSerial();
-  slog << "`powerIn_pin.is_high` = " << powerIn_pin.isHigh() << ".";
+  slog << F("`powerIn_pin.is_high` = ") << powerIn_pin.isHigh() << F(".");
   for (int i = 0; i < LENGTH(cells); i++)
   {
-    slog << "`cells[" << i << "].BalanceCircuit_pin.is_high` = " << cells[i].BalanceCircuit_pin.isHigh() << ".";
+    slog << F("`cells[") << i << F("].BalanceCircuit_pin.is_high` = ") << cells[i].BalanceCircuit_pin.isHigh() << F(".");
   }
-  slog << "`Iin_calibration` = " << Iin_calibration << "[A].";
-  slog << "`Iin` = " << Iin << "[A].";
+  slog << F("`Iin_calibration` = ") << Iin_calibration << F("[A].");
+  slog << F("`Iin` = ") << Iin << F("[A].");
   for (int i = 0; i < LENGTH(Qs); i++)
   {
-    slog << "`Qs[" << i << "]` = " << static_cast<double>(Qs[i]) << "[mAh].";
+    slog << F("`Qs[") << i << F("]` = ") << static_cast<double>(Qs[i]) << F("[mAh].");
   }
 }
 
@@ -503,66 +551,202 @@ void BMS::revive()
   }
   if (lcd_handle == nullptr)
   {
-    serr << "LCD not connected.";
+    serr << F("LCD not connected.");
   }
 }
 
 #elif MAJOR_VERSION <= 2
 
-#define NO_CHARGER_PIN
-
-struct CellManager {
-  PinReader READER_pin;
-#ifndef NO_CHARGER_PIN
-  PinSetter CHARGER_pin;
-#endif
-  PinSetter DISCHARGER_pin;
-};
-  
 namespace BMS {
  
-  constexpr Vol_t V_attatched = 2.7;
-  constexpr Amp_t I_attatched = 0.3;
-  constexpr Vol_t V_wanted    = 4.00;
-  
-  CellManager cells[] =
-  { { .READER_pin = { .pinId = Apin(1) }, .DISCHARGER_pin = { .pinId = Dpin(2) } }
-  , { .READER_pin = { .pinId = Apin(2) }, .DISCHARGER_pin = { .pinId = Dpin(3) } }
+  constexpr mV_t V_attatched = 2700;
+  constexpr mA_t I_attatched = 150;
+  constexpr mV_t V_wanted    = 4000;
+  constexpr mV_t V_tolerance = 50;
+  constexpr mV_t V_calibration  = 200;
+  constexpr mV_t V_calibration2 = 0;
+  constexpr mV_t V_allowed_max  = 4500;
+  constexpr mV_t V_allowed_min  = 2500;
+  constexpr mA_t I_allowed_max  = 2000;
+  constexpr mV_t arduino5V_tolerance = 5;
+  constexpr mA_t Iin_calibration_0 = -260;
+  constexpr mA_t I_charged      = 250;
+  constexpr int  charged_ticks  = 10;
+  constexpr double soc_tolerance = 10.0;
+
+  enum lifecycle_state_t : uint8_t {
+    detached        = 0,
+    balancing       = 1,
+    charging        = 2,
+    finished        = 3,
+    faulted         = 4,
+  };
+
+  enum lifecycle_event_t : uint8_t {
+    cells_attached  = 0,
+    cells_detached  = 1,
+    power_connected = 2,
+    power_lost      = 3,
+    cells_charged   = 4,
+    fault_detected  = 5,
+  };
+
+  typedef PackTopology<PinList<Apin(1), Apin(2)>, PinList<Dpin(2), Dpin(3)>> Pack;
+
+  constexpr int number_of_cells = Pack::number_of_cells;
+
+  static_assert(11 + 6 * number_of_cells <= TELEMETRY_LEN_MAX, "The telemetry frame of the pack is too long.");
+  static_assert(6 + 5 * (number_of_cells + 2) <= TELEMETRY_LEN_MAX, "The telemetry frame of the ADC is too long.");
+  static_assert(number_of_cells < 16, "The pin states of the pack do not fit in `uint16_t`.");
+  static_assert(number_of_cells + 2 <= ADC_READERS_MAX, "The ADC sampler cannot read every tap, `arduino5V_pin` and `Iin_pin`.");
+
+  struct Checkpoint {
+    uint32_t operating_seconds;
+    uint8_t pack_size;
+    int16_t Iin_calibration;
+    int32_t Qs_uAh[number_of_cells];
+    int16_t cellVs_calibration[number_of_cells];
+    int16_t cellVs_calibration2[number_of_cells];
   };
 
+  static_assert(sizeof(Checkpoint) + 4 <= EEPROM_RECORD_MAX, "A checkpoint does not fit in a record of `EepromRing`.");
+
+  Pack          pack;
+  PinGroup      dischargers               = { .pins_ref = &pack.DISCHARGER_pins };
+  PinReader     Iin_pin                   = { .pinId = Apin(3) }; // sampled right after the taps
   PinReader     arduino5V_pin             = { .pinId = Apin(0) };
-  PinReader     Iin_pin                   = { .pinId = Apin(3) };
   PinSetter     powerIn_pin               = { .pinId = Dpin(13) };
-  Timer         Qs_lastUpdatedTime        = { .init_time = 0 };
+  TripLimit     trip_limits[number_of_cells + 1];
+  TripGuard     guard                     = { .limits_ref = &trip_limits, .breaker_ref = &powerIn_pin };
   LcdHandle_t   lcd_handle                = nullptr;
-  Vol_t         arduino5V                 = refOf.arduinoRegularV;
-  Amp_t         Iin                       = 0.00;
-  Amp_t         Iin_calibration           = -0.26;
-  Vol_t         cellVs[LENGTH(cells)]     = { };
-  Vol_t         cellVs_calibration[]      = { 0.20, 0.20 };
-  Vol_t         cellVs_calibration2[]     = { 0.00, 0.00 };
-  mAh_t         Qs[LENGTH(cells)]         = { };
-  int           bms_mode                  = 0;
+  mV_t          arduino5V                 = ROUND(1000.0 * refOf.arduinoRegularV);
+  mA_t          Iin                       = 0;
+  mA_t          Iin_calibration           = Iin_calibration_0;
+  CellStates<number_of_cells> cell_states;
+#if SOC_ESTIMATOR == SOC_EKF
+  // The nominal parameters of a cell, which `setup` copies into `cell_states.ecms` of every cell.
+  EcmParameters const myEcm =
+  { .capacity   = refOf.batteryCapacity
+  , .R0         = 0.25
+  , .R1         = 0.02
+  , .tau        = 30000
+  , .var_of_soc = 0.00000001
+  , .var_of_Vrc = 0.00000001
+  , .var_of_V   = 0.0004
+  };
+#endif
+  mV_t          Vcell_min                 = V_wanted;
+  mV_t          Vcell_max                 = V_attatched;
+  bool          every_cell_being_attatched = false;
+  mV_t          arduino5V_of_limits       = 0;
+  bool          operating_of_limits       = false;
+  int           ticks_of_charged          = 0;
+  int           reader_to_report          = -1;
+  EepromRing    checkpoints               = { .base_address = 0, .size_of_payload = sizeof(Checkpoint), .size_of_ring = E2END + 1 };
+  Checkpoint    last_checkpoint           = { };
+  bool          warm_start                = false;
+  uint32_t      operating_seconds_0       = 0;
+
+  mV_t          (&cellVs)[number_of_cells] = cell_states.cellVs;
+  mAh_t         (&Qs)[number_of_cells]     = cell_states.Qs;
 
   void          setup();
   void          loop();
-  void          routine(Vol_t Vcell_min, Vol_t Vcell_max);
+  void          measure();
+  void          control();
+  void          display();
+  void          report();
+  void          stats();
+  void          checkpoint();
+  void          persist();
+  void          attach();
+  void          release(__FlashStringHelper const *line1, __FlashStringHelper const *line2);
   void          goodbye();
+  void          trip();
+  void          dumpLifecycle();
+
+  Transition const lifecycle_table[] PROGMEM =
+  { { .from = detached,  .event = cells_attached,  .to = balancing, .action = attach }
+  , { .from = balancing, .event = power_connected, .to = charging,  .action = nullptr }
+  , { .from = charging,  .event = power_lost,      .to = balancing, .action = nullptr }
+  , { .from = balancing, .event = cells_detached,  .to = detached,  .action = nullptr }
+  , { .from = charging,  .event = cells_detached,  .to = detached,  .action = nullptr }
+  , { .from = balancing, .event = cells_charged,   .to = finished,  .action = goodbye }
+  , { .from = charging,  .event = cells_charged,   .to = finished,  .action = goodbye }
+  , { .from = finished,  .event = cells_detached,  .to = detached,  .action = nullptr }
+  , { .from = balancing, .event = fault_detected,  .to = faulted,   .action = trip }
+  , { .from = charging,  .event = fault_detected,  .to = faulted,   .action = trip }
+  , { .from = detached,  .event = fault_detected,  .to = faulted,   .action = trip }
+  , { .from = finished,  .event = fault_detected,  .to = faulted,   .action = trip }
+  };
+
+  char const lifecycle_state_names[][10] PROGMEM = { "detached", "balancing", "charging", "finished", "faulted" };
+  char const lifecycle_event_names[][16] PROGMEM = { "cells_attached", "cells_detached", "power_connected", "power_lost", "cells_charged", "fault_detected" };
+
+  StateMachine  lifecycle                 = { .transitions_ref = &lifecycle_table, .init_state = detached, .in_flash = true };
+
+  inline bool isOperating()
+  {
+    uint8_t const state = lifecycle.getState();
+
+    return state == balancing || state == charging;
+  }
+
+  Task tasks[] =
+  { { .job = measure, .period = 10 }
+  , { .job = control, .period = 100 }
+  , { .job = display, .period = 500 }
+  , { .job = report,  .period = 1000 }
+  , { .job = stats,   .period = 1000 }
+  , { .job = checkpoint, .period = 60000 }
+  , { .job = persist, .period = 10 }
+  };
+
+  Scheduler scheduler = { .tasks_ref = &tasks };
 
   void setup()
   {
     Timer hourglass = { };
     invokingSerial();
-    sout << "Runtime begin.";
+    sout << F("Runtime begin.");
     Wire.begin();
-    bms_mode = 0;
+    lifecycle.reset(detached);
+    ticks_of_charged = 0;
+    reader_to_report = -1;
 
     // PIN SETTING
     powerIn_pin.initWith(false);
-    for (int i = 0; i < LENGTH(cells); i++)
+    Pack::forEachCell([](int const cell_no) {
+      pack.DISCHARGER_pins[cell_no].initWith(false);
+      cellVs[cell_no] = 0;
+      cell_states.cellVs_calibration[cell_no] = V_calibration;
+      cell_states.cellVs_calibration2[cell_no] = V_calibration2;
+      Qs[cell_no] = 0;
+#if SOC_ESTIMATOR == SOC_EKF
+      cell_states.ecms[cell_no] = myEcm;
+      cell_states.socEstimators[cell_no].init(&mySocOcvTable, &cell_states.ecms[cell_no]);
+#endif
+    });
+    Pack::forEachCell([](int const cell_no) {
+      guard.watch(cell_no, &pack.READER_pins[cell_no], cell_no > 0 ? &pack.READER_pins[cell_no - 1] : nullptr);
+    });
+    guard.watch(number_of_cells, &Iin_pin, nullptr);
+    arduino5V_of_limits = 0;
+    guard.clear();
+    guard.arm();
+    beginAdcSampler();
+
+    // WARM START
+    warm_start = checkpoints.load(&last_checkpoint) && last_checkpoint.pack_size == number_of_cells;
+    operating_seconds_0 = warm_start ? last_checkpoint.operating_seconds : 0;
+    if (warm_start)
     {
-      cells[i].DISCHARGER_pin.initWith(false);
-      Qs[i] = 0;
+      Iin_calibration = last_checkpoint.Iin_calibration;
+      Pack::forEachCell([](int const cell_no) {
+        cell_states.cellVs_calibration[cell_no] = last_checkpoint.cellVs_calibration[cell_no];
+        cell_states.cellVs_calibration2[cell_no] = last_checkpoint.cellVs_calibration2[cell_no];
+      });
+      sout << F("Checkpoint loaded: operating time = ") << static_cast<int>(last_checkpoint.operating_seconds / 60) << F("[min].");
     }
 
     // GREETING
@@ -570,206 +754,387 @@ namespace BMS {
     if (lcd_handle)
     {
       LcdPrinter lcd = { .lcdHandleRef = lcd_handle };
-      lcd.println("> SYSTEM");
-      lcd.println(" ONLINE");
-      lcd.println("VERSION");
-      lcd.print("= ");
+      lcd.println(F("> SYSTEM"));
+      lcd.println(F(" ONLINE"));
+      lcd.println(F("VERSION"));
+      lcd.print(F("= "));
       lcd.println(VERSION);
     }
 
-    hourglass.delay(3000);
+    // A warm start waits only for the first windows of the ADC sampler, against which the checkpoint is checked.
+    hourglass.delay(warm_start ? 100 : 3000);
+    scheduler.start();
   }
 
   void loop()
   {
-    Timer hourglass = { };
+    scheduler.runOnce();
+  }
 
+  void measure()
+  {
     // MEASURE VALUES
     {
-      Vol_t sensorV = 0.00, accumV = 0.00;
+      mV_t accumV = 0;
 
-      sensorV = refOf.arduinoRegularV * arduino5V_pin.readSignal(10) / refOf.analogSignalMax;
-      arduino5V = refOf.arduinoRegularV * refOf.zenerdiodeVfromRtoA / sensorV;
+      holdAdcWindows();
+      arduino5V = arduino5VOf(arduino5V_pin.readSignalFixed(10));
+      Pack::forEachCell([&](int const cell_no) {
+        mV_t const tapV = tapVOf(arduino5V, pack.READER_pins[cell_no].readSignalFixed(10));
+        cellVs[cell_no] = tapV - accumV;
+        cell_states.cellVs_measured[cell_no] = cellVs[cell_no];
+        accumV = tapV;
+      });
+      Iin = IinOf(arduino5V, Iin_pin.readSignalFixed(5)) - Iin_calibration;
+      releaseAdcWindows();
+    }
 
-      for (int i = 0; i < LENGTH(cells); i++)
-      {
-        constexpr Ohm_t R1 = 18000.0, R2 = 2000.0;
-        sensorV = arduino5V * cells[i].READER_pin.readSignal(10) / refOf.analogSignalMax;
-        cellVs[i] = (sensorV / (R2 / (R1 + R2))) - accumV;
-        accumV += cellVs[i];
-      }
+    // TRACK THE LIMITS OF THE GUARD
+    // The limits are computed again only when `arduino5V` drifts or the lower limit is armed or disarmed.
+    if (arduino5V > arduino5V_of_limits + arduino5V_tolerance || arduino5V < arduino5V_of_limits - arduino5V_tolerance || isOperating() != operating_of_limits)
+    {
+      int const counts_max = tapCountsOf(arduino5V, V_allowed_max);
+      int const counts_min = isOperating() ? tapCountsOf(arduino5V, V_allowed_min) : -TripGuard::no_limit;
 
-      sensorV = arduino5V * Iin_pin.readSignal(5) / refOf.analogSignalMax;
-      Iin = ((sensorV - 0.5 * arduino5V) / refOf.sensitivityOfCurrentSensor) - Iin_calibration;
+      Pack::forEachCell([&](int const cell_no) {
+        guard.setLimits(cell_no, counts_min, counts_max);
+      });
+      guard.setLimits(number_of_cells, -TripGuard::no_limit, IinCountsOf(arduino5V, I_allowed_max + Iin_calibration));
+      arduino5V_of_limits = arduino5V;
+      operating_of_limits = isOperating();
     }
-    
+
+    // INTEGRATE IIN
+    if (isOperating())
     {
-      bool every_cell_being_attatched = true;
-      Vol_t Vcell_min = V_wanted;
-      Vol_t Vcell_max = V_attatched;
+      us_t const now = clockMicros();
 
-      for (int i = 0; i < LENGTH(cellVs); i++)
-      {
-        if (Vcell_min > cellVs[i])
+      Pack::forEachCell([&](int const cell_no) {
+        cell_states.Qs_counters[cell_no].integrate(now, Iin, not pack.DISCHARGER_pins[cell_no].isHigh());
+      });
+    }
+
+    {
+      Vcell_min = V_wanted;
+      Vcell_max = V_attatched;
+      every_cell_being_attatched = true;
+
+      Pack::forEachCell([](int const cell_no) {
+        if (Vcell_min > cellVs[cell_no])
         {
-          Vcell_min = cellVs[i];
+          Vcell_min = cellVs[cell_no];
         }
-      }
-      for (int i = 0; i < LENGTH(cellVs); i++)
-      {
-        if (Vcell_max < cellVs[i])
+        if (Vcell_max < cellVs[cell_no])
         {
-          Vcell_max = cellVs[i];
+          Vcell_max = cellVs[cell_no];
         }
-      }
-      for (int i = 0; i < LENGTH(cellVs); i++)
-      {
-        every_cell_being_attatched &= cellVs[i] > V_attatched;
-      }
+        every_cell_being_attatched &= cellVs[cell_no] > V_attatched;
+      });
 
       // calibration
-      for (int i = 0; i < LENGTH(cellVs); i++)
-      {
+      Pack::forEachCell([](int const cell_no) {
         if (Iin > I_attatched)
         {
-          cellVs[i] -= cellVs_calibration[i];
+          cellVs[cell_no] -= cell_states.cellVs_calibration[cell_no];
         }
-        else if (cellVs[i] > Vcell_min + 0.05)
+        else if (cellVs[cell_no] > Vcell_min + V_tolerance)
         {
-          cellVs[i] -= cellVs_calibration2[i];
+          cellVs[cell_no] -= cell_states.cellVs_calibration2[cell_no];
         }
         else
         {
         }
-      }
-      switch(bms_mode)
+      });
+    }
+
+    // RAISE EVENTS
+    {
+      if (guard.getFault() != 0)
       {
-      case 0:
-        if (every_cell_being_attatched)
-        {
-          bms_mode = 1;
-          powerIn_pin.turnOn();
-          if (lcd_handle)
-          {
-            LcdPrinter lcd = { .lcdHandleRef = lcd_handle };
-            lcd.println("ALL CELL");
-            lcd.println("S ARE RE");
-            lcd.println("COGNIZED");
-          }
-          for (int cell_no = 0; cell_no < LENGTH(Qs); cell_no++)
-          {
-            Qs[cell_no] = refOf.batteryCapacity * mySocOcvTable.get_x_by_y(cellVs[cell_no]) / 100.0;
-          }
-          Qs_lastUpdatedTime.reset();
-        }
-        break;
-      default:
-        if (every_cell_being_attatched)
-        {
-          routine(Vcell_min, Vcell_max);
-        }
-        else
-        {
-          bms_mode = 0;
-        }
-        break;
+        lifecycle.raise(fault_detected);
       }
+      lifecycle.raise(every_cell_being_attatched ? cells_attached : cells_detached);
+      lifecycle.raise(Iin > I_attatched ? power_connected : power_lost);
     }
-
-    hourglass.delay(100000);
   }
-  
-  void routine(Vol_t const Vcell_min, Vol_t const Vcell_max)
+
+  void control()
   {
-    // REPORT VALUES
+    if (not isOperating())
     {
-      for (int cell_no = 0; cell_no < LENGTH(cells); cell_no++)
-      {
-        if (not cells[cell_no].DISCHARGER_pin.isHigh())
-        {
-          Qs[cell_no] += Iin * Qs_lastUpdatedTime.getDuration() / 3600.0;
-        }
-      }
-      Qs_lastUpdatedTime.reset();
-      sout << "arduino5V = " << arduino5V << "[V].";
-      sout << "Iin = " << Iin << "[A].";
-      for (int i = 0; i < LENGTH(cellVs); i++)
-      {
-        sout << "cellVs[" << i << "] = " << cellVs[i] << "[V].";
-      }
-      if (lcd_handle)
-      {
-        LcdPrinter lcd = { .lcdHandleRef = lcd_handle };
-        for (int cell_no = 0; cell_no < LENGTH(cellVs); cell_no++)
-        {
-          double const soc = 100.0 * Qs[cell_no] / refOf.batteryCapacity;
-          lcd.print("B");
-          lcd.print(cell_no + 1);
-          lcd.print("=");
-          lcd.println(cellVs[cell_no]);
-          lcd.print(" ");
-          lcd.print(soc);
-          lcd.println("%");
-        }
-        lcd.print("I");
-        lcd.print("=");
-        lcd.println(Iin);
-      }
+      return;
+    }
+
+    // UPDATE QS
+    {
+#if SOC_ESTIMATOR == SOC_EKF
+      us_t const now = clockMicros();
+
+      Pack::forEachCell([&](int const cell_no) {
+        bool const counting = not pack.DISCHARGER_pins[cell_no].isHigh();
+
+        cell_states.socEstimators[cell_no].update(cell_states.Qs_counters[cell_no].get_uAms(), now, counting ? Iin : 0, cell_states.cellVs_measured[cell_no], counting);
+        Qs[cell_no] = cell_states.ecms[cell_no].capacity * cell_states.socEstimators[cell_no].get_soc() / 100.0;
+      });
+#else
+      Pack::forEachCell([](int const cell_no) {
+        Qs[cell_no] = cell_states.Qs_counters[cell_no].get_mAh();
+      });
+#endif
     }
 
     // CONTROL PINS
     {
       bool weAreDone = true;
 
-      if (Iin > I_attatched)
+      if (lifecycle.getState() == charging)
       {
-        for (int cell_no = 0; cell_no < LENGTH(cellVs); cell_no++)
-        {
+        // Under a charging current, `cellVs` are off by the drop over the wires,
+        // hence a cell near `V_wanted` is charged once the current tapers at the constant voltage of the charger.
+        bool const tapered = Iin < I_charged;
+
+        Pack::forEachCell([&](int const cell_no) {
           if (cellVs[cell_no] <= V_wanted)
           {
-            cells[cell_no].DISCHARGER_pin.turnOff();
-            weAreDone = false;
+            dischargers.set(cell_no, false);
+            weAreDone &= tapered && cellVs[cell_no] >= V_wanted - V_tolerance;
           }
           else
           {
-            if (cellVs[cell_no] > Vcell_min + 0.05)
+            if (cellVs[cell_no] > Vcell_min + V_tolerance)
             {
-              cells[cell_no].DISCHARGER_pin.turnOn();
+              dischargers.set(cell_no, true);
               weAreDone = false;
             }
             else
             {
-              cells[cell_no].DISCHARGER_pin.turnOff();
+              dischargers.set(cell_no, false);
             }              
           }
-        }
+        });
       }
       else
       {
-        for (int i = 0; i < LENGTH(cellVs); i++)
-        {
-          if (cellVs[i] > Vcell_min + 0.05)
+        Pack::forEachCell([&](int const cell_no) {
+          if (cellVs[cell_no] > Vcell_min + V_tolerance)
           {
-            cells[i].DISCHARGER_pin.turnOn();
+            dischargers.set(cell_no, true);
             weAreDone = false;
           }
           else
           {
-            cells[i].DISCHARGER_pin.turnOff();
+            dischargers.set(cell_no, false);
+            weAreDone &= cellVs[cell_no] > V_wanted;
           }
-        }
+        });
       }
-      
-      if (weAreDone)
+      dischargers.commit();
+
+      // A single noisy reading must not end the charging.
+      ticks_of_charged = weAreDone ? ticks_of_charged + 1 : 0;
+      if (ticks_of_charged >= charged_ticks)
       {
-        goodbye();
+        lifecycle.raise(cells_charged);
       }
     }
   }
+
+  void display()
+  {
+    if (isOperating() && lcd_handle)
+    {
+      LcdPrinter lcd = { .lcdHandleRef = lcd_handle };
+      Pack::forEachCell([&](int const cell_no) {
+        double const soc = 100.0 * Qs[cell_no] / refOf.batteryCapacity;
+        lcd.print(F("B"));
+        lcd.print(cell_no + 1);
+        lcd.print(F("="));
+        lcd.println(cellVs[cell_no] / 1000.0);
+        lcd.print(F(" "));
+        lcd.print(soc);
+        lcd.println(F("%"));
+      });
+      lcd.print(F("I"));
+      lcd.print(F("="));
+      lcd.println(Iin / 1000.0);
+    }
+  }
+
+  void report()
+  {
+    if (isOperating())
+    {
+#if TELEMETRY_MODE == TELEMETRY_BINARY
+      TelemetryFrame frame = { .type = 0x01 };
+      uint16_t pin_states = powerIn_pin.isHigh();
+      frame.putU32(millis());
+      frame.putI16(arduino5V);
+      frame.putI16(Iin);
+      frame.putU8(number_of_cells);
+      Pack::forEachCell([&](int const cell_no) {
+        frame.putI16(cellVs[cell_no]);
+      });
+      Pack::forEachCell([&](int const cell_no) {
+        frame.putI32(ROUND(1000.0 * Qs[cell_no]));
+      });
+      Pack::forEachCell([&](int const cell_no) {
+        pin_states |= pack.DISCHARGER_pins[cell_no].isHigh() << (cell_no + 1);
+      });
+      frame.putU16(pin_states);
+#else
+      sout << F("arduino5V = ") << arduino5V / 1000.0 << F("[V].");
+      sout << F("Iin = ") << Iin / 1000.0 << F("[A].");
+      Pack::forEachCell([](int const cell_no) {
+        sout << F("cellVs[") << cell_no << F("] = ") << cellVs[cell_no] / 1000.0 << F("[V].");
+      });
+#endif
+    }
+  }
+
+  void stats()
+  {
+#if TELEMETRY_MODE == TELEMETRY_BINARY
+    TelemetryFrame frame = { .type = 0x02 };
+    auto const put = [&](PinReader const &reader) {
+      frame.putU8(reader.pin_to_handle);
+      frame.putU16(reader.getWindowLength());
+      frame.putU16(reader.getVariance());
+    };
+    scheduler.report();
+    frame.putU32(millis());
+    frame.putU8(number_of_cells + 2);
+    put(arduino5V_pin);
+    put(Iin_pin);
+    Pack::forEachCell([&](int const cell_no) {
+      put(pack.READER_pins[cell_no]);
+    });
+#else
+    // One line per call, the tasks first and then the readers, so that a call fits the serial ring buffer.
+    if (reader_to_report < 0)
+    {
+      reader_to_report = scheduler.report() ? 0 : -1;
+      return;
+    }
+
+    PinReader const &reader = reader_to_report == 0 ? arduino5V_pin : reader_to_report == 1 ? Iin_pin : pack.READER_pins[reader_to_report - 2];
+
+    slog << F("ADC of the pin ") << reader.pin_to_handle << F(": window = ") << static_cast<int>(reader.getWindowLength()) << F(", variance = ") << reader.getVariance() / 256.0 << F("[counts^2].");
+    reader_to_report = reader_to_report + 1 < number_of_cells + 2 ? reader_to_report + 1 : -1;
+#endif
+  }
+
+  void checkpoint()
+  {
+    if (isOperating())
+    {
+      Checkpoint record;
+      // The crc of `EepromRing` covers the padding of the record as well, hence it must be zeroed.
+      memset(&record, 0, sizeof(record));
+      record.operating_seconds = operating_seconds_0 + millis() / 1000;
+      record.pack_size = number_of_cells;
+      record.Iin_calibration = Iin_calibration;
+      Pack::forEachCell([&](int const cell_no) {
+        record.Qs_uAh[cell_no] = ROUND(1000.0 * Qs[cell_no]);
+        record.cellVs_calibration[cell_no] = cell_states.cellVs_calibration[cell_no];
+        record.cellVs_calibration2[cell_no] = cell_states.cellVs_calibration2[cell_no];
+      });
+      checkpoints.save(&record);
+    }
+  }
+
+  void persist()
+  {
+    checkpoints.pump();
+  }
   
+  void attach()
+  {
+    powerIn_pin.turnOn();
+    if (lcd_handle)
+    {
+      LcdPrinter lcd = { .lcdHandleRef = lcd_handle };
+      lcd.println(F("ALL CELL"));
+      lcd.println(F("S ARE RE"));
+      lcd.println(F("COGNIZED"));
+    }
+    // A checkpoint may be of any age, hence the soc of it must agree with the ocv of the cells at rest.
+    if (warm_start && -I_attatched < Iin && Iin < I_attatched)
+    {
+      Pack::forEachCell([](int const cell_no) {
+        double const soc_of_checkpoint = 100.0 * last_checkpoint.Qs_uAh[cell_no] / 1000.0 / refOf.batteryCapacity;
+        double const soc_of_ocv = mySocOcvTable.get_x_by_y(cellVs[cell_no] / 1000.0);
+
+        if (fabs(soc_of_checkpoint - soc_of_ocv) > soc_tolerance)
+        {
+          warm_start = false;
+        }
+      });
+      if (not warm_start)
+      {
+        serr << F("Checkpoint rejected: the soc disagrees with the ocv at rest.");
+        operating_seconds_0 = 0;
+        Iin_calibration = Iin_calibration_0;
+        arduino5V_of_limits = 0;
+        Pack::forEachCell([](int const cell_no) {
+          cell_states.cellVs_calibration[cell_no] = V_calibration;
+          cell_states.cellVs_calibration2[cell_no] = V_calibration2;
+        });
+      }
+    }
+    else if (warm_start)
+    {
+      // Under a current of `I_attatched` or more, the cellVs are off the ocv by the drop over the internal resistance,
+      // which is not known well enough to correct; the checkpoint is trusted unchecked then.
+      serr << F("Checkpoint unchecked: the cells are not at rest.");
+    }
+    Pack::forEachCell([](int const cell_no) {
+      if (warm_start)
+      {
+        Qs[cell_no] = last_checkpoint.Qs_uAh[cell_no] / 1000.0;
+      }
+      else
+      {
+        Qs[cell_no] = refOf.batteryCapacity * mySocOcvTable.get_x_by_y(cellVs[cell_no] / 1000.0) / 100.0;
+      }
+      cell_states.Qs_counters[cell_no].reset(Qs[cell_no]);
+#if SOC_ESTIMATOR == SOC_EKF
+      cell_states.socEstimators[cell_no].reset(100.0 * Qs[cell_no] / cell_states.ecms[cell_no].capacity, cell_states.Qs_counters[cell_no].get_uAms(), clockMicros());
+#endif
+    });
+    warm_start = false;
+  }
+
+  void release(__FlashStringHelper const *const line1, __FlashStringHelper const *const line2)
+  {
+    powerIn_pin.turnOff();
+    Pack::forEachCell([](int const cell_no) {
+      dischargers.set(cell_no, false);
+    });
+    dischargers.commit();
+    if (lcd_handle)
+    {
+      LcdPrinter lcd = { .lcdHandleRef = lcd_handle };
+      lcd.clear();
+      lcd.println(line1);
+      lcd.println(line2);
+    }
+  }
+
   void goodbye()
   {
-    // TODO
+    sout << F("CHARGING COMPLETED.");
+    release(F("CHARGING"), F("FINISHED"));
+  }
+
+  void trip()
+  {
+    serr << F("Fault detected: code = ") << guard.getFault() << F(", Iin = ") << Iin / 1000.0 << F("[A].");
+    release(F(" FAULT! "), F("POWEROFF"));
+  }
+
+  void dumpLifecycle()
+  {
+    lifecycle.dump(lifecycle_state_names, lifecycle_event_names);
   }
 }
 
@@ -11,122 +11,145 @@
 #include "capstone.hpp"
 
 static constexpr
-double const Ocvs[] =
-{ 2.58503333333333
-, 2.90561016666667
-, 3.08249133333333
-, 3.17952500000000
-, 3.23710133333333
-, 3.28095000000000
-, 3.32413333333333
-, 3.36478333333333
-, 3.39867500000000
-, 3.42519616666667
-, 3.44861666666667
-, 3.47358333333333
-, 3.49503333333333
-, 3.51346083333333
-, 3.53090000000000
-, 3.55185000000000
-, 3.57477500000000
-, 3.59708333333333
-, 3.61538333333333
-, 3.63258333333333
-, 3.64896666666667
-, 3.66485000000000
-, 3.68090000000000
-, 3.69781666666667
-, 3.71550000000000
-, 3.73357500000000
-, 3.75171666666667
-, 3.76967500000000
-, 3.78728333333333
-, 3.80435000000000
-, 3.82127500000000
-, 3.83885000000000
-, 3.85778333333333
-, 3.87864166666667
-, 3.89880666666667
-, 3.91662500000000
-, 3.93353333333333
-, 3.95168333333333
-, 3.97141666666667
-, 3.99261666666667
-, 4.01393333333333
-, 4.03435833333333
-, 4.05259166666667
-, 4.06720000000000
-, 4.07875833333333
-, 4.08877250000000
-, 4.09895833333333
-, 4.11148333333333
-, 4.12865833333333
-, 4.15507500000000
-, 4.20280000000000
+Val_t baseOfVs = 2.50, unitOfVs = 0.0001;
+
+static constexpr
+uint16_t codeOfV(Val_t const V)
+{
+  return encodeU16(V, baseOfVs, unitOfVs);
+}
+
+static constexpr
+uint16_t const Ocvs[] PROGMEM =
+{ codeOfV(2.58503333333333)
+, codeOfV(2.90561016666667)
+, codeOfV(3.08249133333333)
+, codeOfV(3.17952500000000)
+, codeOfV(3.23710133333333)
+, codeOfV(3.28095000000000)
+, codeOfV(3.32413333333333)
+, codeOfV(3.36478333333333)
+, codeOfV(3.39867500000000)
+, codeOfV(3.42519616666667)
+, codeOfV(3.44861666666667)
+, codeOfV(3.47358333333333)
+, codeOfV(3.49503333333333)
+, codeOfV(3.51346083333333)
+, codeOfV(3.53090000000000)
+, codeOfV(3.55185000000000)
+, codeOfV(3.57477500000000)
+, codeOfV(3.59708333333333)
+, codeOfV(3.61538333333333)
+, codeOfV(3.63258333333333)
+, codeOfV(3.64896666666667)
+, codeOfV(3.66485000000000)
+, codeOfV(3.68090000000000)
+, codeOfV(3.69781666666667)
+, codeOfV(3.71550000000000)
+, codeOfV(3.73357500000000)
+, codeOfV(3.75171666666667)
+, codeOfV(3.76967500000000)
+, codeOfV(3.78728333333333)
+, codeOfV(3.80435000000000)
+, codeOfV(3.82127500000000)
+, codeOfV(3.83885000000000)
+, codeOfV(3.85778333333333)
+, codeOfV(3.87864166666667)
+, codeOfV(3.89880666666667)
+, codeOfV(3.91662500000000)
+, codeOfV(3.93353333333333)
+, codeOfV(3.95168333333333)
+, codeOfV(3.97141666666667)
+, codeOfV(3.99261666666667)
+, codeOfV(4.01393333333333)
+, codeOfV(4.03435833333333)
+, codeOfV(4.05259166666667)
+, codeOfV(4.06720000000000)
+, codeOfV(4.07875833333333)
+, codeOfV(4.08877250000000)
+, codeOfV(4.09895833333333)
+, codeOfV(4.11148333333333)
+, codeOfV(4.12865833333333)
+, codeOfV(4.15507500000000)
+, codeOfV(4.20280000000000)
 };
 
 static constexpr
-double const Vcells[] =
-{ 2.66267511813557
-, 2.97909231310534
-, 3.15181171748037
-, 3.24468356838222
-, 3.29809792716228
-, 3.33778453294892
-, 3.37680578063660
-, 3.41329372011026
-, 3.44466601673130
-, 3.47031048551871
-, 3.49285426808954
-, 3.51978808018582
-, 3.54320525035293
-, 3.56214602168726
-, 3.57864450857180
-, 3.59865380849759
-, 3.62067556734825
-, 3.64208066794380
-, 3.66010221339239
-, 3.67764853589568
-, 3.69437819596763
-, 3.70707134127572
-, 3.71993114490973
-, 3.73597886771615
-, 3.75511455306103
-, 3.77464191405084
-, 3.79197083330198
-, 3.80911640699331
-, 3.82691894748863
-, 3.84518682039352
-, 3.86331301488147
-, 3.88192541341650
-, 3.90189614253335
-, 3.92371543493947
-, 3.94476496089448
-, 3.96346782009276
-, 3.98366306348376
-, 4.00509997476904
-, 4.02672013086287
-, 4.04840685013661
-, 4.07021024043437
-, 4.09100964963846
-, 4.10961739386516
-, 4.12382483356325
-, 4.13420693125392
-, 4.14304485813845
-, 4.15211217441638
-, 4.16351864156142
-, 4.17895109940276
-, 4.20300118506630
+uint16_t const Vcells[] PROGMEM =
+{ codeOfV(2.66267511813557)
+, codeOfV(2.97909231310534)
+, codeOfV(3.15181171748037)
+, codeOfV(3.24468356838222)
+, codeOfV(3.29809792716228)
+, codeOfV(3.33778453294892)
+, codeOfV(3.37680578063660)
+, codeOfV(3.41329372011026)
+, codeOfV(3.44466601673130)
+, codeOfV(3.47031048551871)
+, codeOfV(3.49285426808954)
+, codeOfV(3.51978808018582)
+, codeOfV(3.54320525035293)
+, codeOfV(3.56214602168726)
+, codeOfV(3.57864450857180)
+, codeOfV(3.59865380849759)
+, codeOfV(3.62067556734825)
+, codeOfV(3.64208066794380)
+, codeOfV(3.66010221339239)
+, codeOfV(3.67764853589568)
+, codeOfV(3.69437819596763)
+, codeOfV(3.70707134127572)
+, codeOfV(3.71993114490973)
+, codeOfV(3.73597886771615)
+, codeOfV(3.75511455306103)
+, codeOfV(3.77464191405084)
+, codeOfV(3.79197083330198)
+, codeOfV(3.80911640699331)
+, codeOfV(3.82691894748863)
+, codeOfV(3.84518682039352)
+, codeOfV(3.86331301488147)
+, codeOfV(3.88192541341650)
+, codeOfV(3.90189614253335)
+, codeOfV(3.92371543493947)
+, codeOfV(3.94476496089448)
+, codeOfV(3.96346782009276)
+, codeOfV(3.98366306348376)
+, codeOfV(4.00509997476904)
+, codeOfV(4.02672013086287)
+, codeOfV(4.04840685013661)
+, codeOfV(4.07021024043437)
+, codeOfV(4.09100964963846)
+, codeOfV(4.10961739386516)
+, codeOfV(4.12382483356325)
+, codeOfV(4.13420693125392)
+, codeOfV(4.14304485813845)
+, codeOfV(4.15211217441638)
+, codeOfV(4.16351864156142)
+, codeOfV(4.17895109940276)
+, codeOfV(4.20300118506630)
 };
 
+static
+uint8_t OcvsIndex[64] = { };
+
+static
+uint8_t VcellsIndex[64] = { };
+
 AscList const mySocOcvTable =
 { .data_sheet_ref = &Ocvs
+, .base           = baseOfVs
+, .unit           = unitOfVs
 , .left_bound     = 0.00
 , .right_bound    = 100.00
+, .index_ref      = &OcvsIndex
+, .in_flash       = true
 };
 
 AscList const mySocVcellTable =
 { .data_sheet_ref = &Vcells
+, .base           = baseOfVs
+, .unit           = unitOfVs
 , .left_bound     = 0.00
 , .right_bound    = 98.00
+, .index_ref      = &VcellsIndex
+, .in_flash       = true
 };
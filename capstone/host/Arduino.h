@@ -0,0 +1,115 @@
+/* <CAPSTONE PROJECT>
+** ===============================================================================
+** MEMBER        | AFFILIATION                                                   |
+** ===============================================================================
+** Hwan-hee Jeon | School of Mechanical Engineering, Chonnam National University |
+** Hak-jung Im   | School of Mechanical Engineering, Chonnam National University |
+** Ki-jeong Lim  | School of Mechanical Engineering, Chonnam National University |
+** ===============================================================================
+*/
+
+// include-guard
+#ifndef CAPSTONE_HOST_ARDUINO
+#define CAPSTONE_HOST_ARDUINO
+
+// required libraries
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+// macro defns
+#define HIGH              0x1
+#define LOW               0x0
+#define INPUT             0x0
+#define OUTPUT            0x1
+#define DEC               10
+#define HEX               16
+#define PROGMEM           __attribute__((section(".progmem.data")))
+#define PSTR(str)         (__extension__({ static char const __c[] PROGMEM = (str); &__c[0]; }))
+#define F(str)            (reinterpret_cast<__FlashStringHelper const *>(PSTR(str)))
+#define memcpy_P          memcpy
+#define pgm_read_byte(address) (*reinterpret_cast<uint8_t const *>(address))
+#define ISR(vector)       void vector()
+#define ADC_vect          adcConversionComplete
+
+// bits of the ADC registers of ATmega328P
+#define REFS0             6
+#define ADEN              7
+#define ADSC              6
+#define ADIE              3
+#define ADPS2             2
+#define ADPS1             1
+#define ADPS0             0
+
+// type synonym defns
+typedef uint8_t byte;
+typedef bool boolean;
+class __FlashStringHelper;
+
+// pins of Arduino Uno
+static uint8_t const A0 = 14;
+static uint8_t const A1 = 15;
+static uint8_t const A2 = 16;
+static uint8_t const A3 = 17;
+static uint8_t const A4 = 18;
+static uint8_t const A5 = 19;
+static uint8_t const A6 = 20;
+static uint8_t const A7 = 21;
+
+// implemented in "hal.cpp"
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int digitalRead(uint8_t pin);
+int analogRead(uint8_t pin);
+void analogWrite(uint8_t pin, int val);
+void noInterrupts();
+void interrupts();
+class HardwareSerial {
+public:
+  void begin(unsigned long baud);
+  void end();
+  operator bool() const;
+  int availableForWrite();
+  size_t write(uint8_t ch);
+  void flush();
+  void print(char const *str);
+  void println(char const *str);
+private:
+  void drain();
+  unsigned long baud = 0;
+  int queued = 0;
+  uint64_t drained_time = 0;
+};
+extern HardwareSerial Serial;
+class AdcControlRegister {
+public:
+  uint8_t bits;
+  operator uint8_t();
+  AdcControlRegister &operator=(uint8_t val);
+  AdcControlRegister &operator|=(uint8_t val);
+  AdcControlRegister &operator&=(uint8_t val);
+};
+extern uint8_t ADMUX;
+extern AdcControlRegister ADCSRA;
+extern uint16_t ADC;
+void ADC_vect();
+/* Comments
+** 1. A stand-in of <Arduino.h> for the host simulation.
+** 2. Only the part used by the sketch is provided.
+** 3. `PROGMEM` data stays in the ordinary memory, and `memcpy_P` is `memcpy`,
+**    but it is gathered in the section `.progmem.data` as on AVR,
+**    so that "build.sh" can tell it from the literals which would be copied into the SRAM.
+** 4. Time is virtual; it advances by `delay`, by conversions of `analogRead`,
+**    and by a few microseconds on each call of `millis` or `micros`.
+** 5. `ADMUX`, `ADCSRA` and `ADC` imitate the ADC of ATmega328P:
+**    setting `ADSC` with `ADEN` starts a conversion of 104 microseconds in the virtual time,
+**    at the end of which `ADC_vect` is called if `ADIE` is set and the interrupts are enabled.
+**    Reading `ADCSRA` during a conversion takes a microsecond, so that busy-waiting on `ADSC` ends.
+*/
+
+#endif
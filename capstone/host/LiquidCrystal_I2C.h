@@ -0,0 +1,39 @@
+/* <CAPSTONE PROJECT>
+** ===============================================================================
+** MEMBER        | AFFILIATION                                                   |
+** ===============================================================================
+** Hwan-hee Jeon | School of Mechanical Engineering, Chonnam National University |
+** Hak-jung Im   | School of Mechanical Engineering, Chonnam National University |
+** Ki-jeong Lim  | School of Mechanical Engineering, Chonnam National University |
+** ===============================================================================
+*/
+
+// include-guard
+#ifndef CAPSTONE_HOST_LIQUIDCRYSTAL_I2C
+#define CAPSTONE_HOST_LIQUIDCRYSTAL_I2C
+
+#include "Arduino.h"
+
+// implemented in "hal.cpp"
+class LiquidCrystal_I2C {
+  int const cols;
+  int const rows;
+  int cursor_col;
+  int cursor_row;
+public:
+  LiquidCrystal_I2C(uint8_t adr, uint8_t lcd_cols, uint8_t lcd_rows);
+  void init();
+  void backlight();
+  void noBacklight();
+  void clear();
+  void setCursor(uint8_t col, uint8_t row);
+  size_t write(uint8_t ch);
+  void print(char const *str);
+  void print(int num);
+};
+/* Comments
+** 1. A stand-in of "LiquidCrystal_I2C.h" for the host simulation.
+** 2. The screen is kept by "hal.cpp", and counted I2C traffic is reported by the simulation.
+*/
+
+#endif
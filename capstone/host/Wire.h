@@ -0,0 +1,32 @@
+/* <CAPSTONE PROJECT>
+** ===============================================================================
+** MEMBER        | AFFILIATION                                                   |
+** ===============================================================================
+** Hwan-hee Jeon | School of Mechanical Engineering, Chonnam National University |
+** Hak-jung Im   | School of Mechanical Engineering, Chonnam National University |
+** Ki-jeong Lim  | School of Mechanical Engineering, Chonnam National University |
+** ===============================================================================
+*/
+
+// include-guard
+#ifndef CAPSTONE_HOST_WIRE
+#define CAPSTONE_HOST_WIRE
+
+#include "Arduino.h"
+
+// implemented in "hal.cpp"
+class TwoWire {
+  uint8_t address;
+public:
+  void begin();
+  void end();
+  void beginTransmission(uint8_t adr);
+  uint8_t endTransmission(uint8_t send_stop = true);
+};
+extern TwoWire Wire;
+/* Comments
+** 1. A stand-in of <Wire.h> for the host simulation.
+** 2. Only the address of the simulated LCD acknowledges.
+*/
+
+#endif
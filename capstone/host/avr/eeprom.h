@@ -0,0 +1,33 @@
+/* <CAPSTONE PROJECT>
+** ===============================================================================
+** MEMBER        | AFFILIATION                                                   |
+** ===============================================================================
+** Hwan-hee Jeon | School of Mechanical Engineering, Chonnam National University |
+** Hak-jung Im   | School of Mechanical Engineering, Chonnam National University |
+** Ki-jeong Lim  | School of Mechanical Engineering, Chonnam National University |
+** ===============================================================================
+*/
+
+// include-guard
+#ifndef CAPSTONE_HOST_AVR_EEPROM
+#define CAPSTONE_HOST_AVR_EEPROM
+
+// required libraries
+#include <stddef.h>
+#include <stdint.h>
+
+// macro defns
+#define E2END             0x3FF
+
+// implemented in "hal.cpp"
+bool eeprom_is_ready();
+uint8_t eeprom_read_byte(uint8_t const *address);
+void eeprom_read_block(void *dst, void const *src, size_t len);
+void eeprom_update_byte(uint8_t *address, uint8_t val);
+/* Comments
+** 1. A stand-in of <avr/eeprom.h> for the host simulation.
+** 2. The EEPROM of `E2END + 1` bytes keeps its contents while the simulation runs,
+**    and each written byte keeps the EEPROM busy for 3.4ms of virtual time.
+*/
+
+#endif
@@ -0,0 +1,342 @@
+/* <CAPSTONE PROJECT>
+** ===============================================================================
+** MEMBER        | AFFILIATION                                                   |
+** ===============================================================================
+** Hwan-hee Jeon | School of Mechanical Engineering, Chonnam National University |
+** Hak-jung Im   | School of Mechanical Engineering, Chonnam National University |
+** Ki-jeong Lim  | School of Mechanical Engineering, Chonnam National University |
+** ===============================================================================
+*/
+
+/* Comments
+** [bench]
+** 1. Host microbenchmarks of the primitives in "utilities.cpp" and "printers.cpp".
+** 2. Usage
+** > sh capstone/host/build.sh
+** > ./_host_build/bench [results.csv = _host_build/bench_results.csv]
+** 3. Each benchmark reports
+**    (1) `ns_per_op`, which is measured on the host, and
+**    (2) `avr_cycles_estimate`, which is a static estimate by `AvrCost`,
+**        a cost model of the soft-float and multi-byte integer routines of avr-gcc.
+**        It is neither counted nor measured: the operations of a call are read off the code under test by hand,
+**        and written next to its benchmark as `estimate*`, which must be revised whenever that code changes.
+** 4. Inputs are drawn from `mySocOcvTable`, i.e. from the tables in "data.ino".
+** 5. `LegacyFormatter` is the formatter before the linear-time `SizedFormatter`,
+**    kept here as the baseline.
+*/
+
+#include <chrono>
+#include <stdio.h>
+#include "hal.hpp"
+#include "capstone.hpp"
+
+namespace AvrCost {
+  // Approximate cycles of avr-gcc 7.3 / avr-libc 2.0 routines on ATmega328P.
+  constexpr double cost_fadd   = 110.0;
+  constexpr double cost_fmul   = 150.0;
+  constexpr double cost_fdiv   = 480.0;
+  constexpr double cost_fcmp   = 50.0;
+  constexpr double cost_fconv  = 80.0;
+  constexpr double cost_mul32  = 60.0;
+  constexpr double cost_div32  = 580.0;
+  constexpr double cost_mul64  = 300.0;
+  constexpr double cost_div64  = 2500.0;
+  constexpr double cost_step   = 12.0;
+  // Operations shared by the estimates below.
+  constexpr double interpolate = 3 * cost_fadd + cost_fdiv + cost_fmul + cost_fadd + cost_fconv;
+  constexpr double parameter = cost_fadd + cost_fmul + cost_fdiv + cost_fadd + cost_fconv;
+  constexpr double encode = cost_fadd + cost_fmul + 2 * cost_fcmp + cost_fconv + 2 * (4 + cost_step);
+  constexpr double interpolate_codes = 2 * cost_fconv + cost_fadd + cost_fdiv + cost_fadd;
+  constexpr double map2d_step = cost_fcmp + 2 * cost_fadd + cost_fmul + 2 * cost_fcmp + cost_step;
+  constexpr double digit32 = cost_div32 + cost_step;
+  constexpr double digit64legacy = 2.5 * cost_mul64 + cost_mul64 + 2 * cost_div64 + cost_step;
+  constexpr double put_double = cost_fmul + cost_fadd + cost_fconv + 2 * cost_mul64 + 2 * cost_div32 + 4 * digit32;
+}
+using namespace AvrCost;
+
+template <size_t Capacity>
+class LegacyFormatter {
+  int cnt = 0;
+  char buf[Capacity] = { };
+public:
+  void putChar(char const printMe)
+  {
+    if (cnt < static_cast<int>(Capacity))
+    {
+      buf[cnt++] = printMe;
+    }
+  }
+  void putDigit(int const printMe)
+  {
+    if (printMe >= 0 && printMe < 16)
+    {
+      this->putChar("0123456789ABCDEF"[printMe]);
+    }
+  }
+  void putInt(BigInt_t const printMe, int const base)
+  {
+    int cn = 0;
+    BigInt_t val = printMe;
+    if (val < 0)
+    {
+      this->putChar('-');
+      val *= -1;
+    }
+    for (BigInt_t _val = 1; _val <= val; _val *= base)
+    {
+      cn++;
+    }
+    do
+    {
+      this->putDigit(((base * val) / POW(base, cn)) % base);
+    } while (--cn > 0);
+  }
+  void putDouble(double const printMe, int const afters_dot)
+  {
+    constexpr int base = 10;
+    double val = printMe;
+    if (printMe < 0.0)
+    {
+      this->putChar('-');
+      val *= -1;
+    }
+    int cn = afters_dot;
+    BigInt_t pow10_afters_dot = POW(base, afters_dot);
+    BigInt_t valN = ROUND(val * pow10_afters_dot);
+    BigInt_t valF = valN % pow10_afters_dot;
+    valN /= pow10_afters_dot;
+    this->putInt(valN, base);
+    this->putChar('.');
+    do
+    {
+      this->putDigit(((base * valF) / POW(base, cn)) % base);
+    } while (--cn > 0);
+  }
+  char front() const
+  {
+    return buf[0];
+  }
+};
+
+struct Benchmark {
+  char const *name;
+  double (*run)(int i);
+  double avr_cycles_estimate;
+};
+
+constexpr int number_of_inputs = 1024;
+static Val_t soc_inputs[number_of_inputs];
+static Val_t ocv_inputs[number_of_inputs];
+static Val_t temperature_inputs[number_of_inputs];
+static int mV_inputs[number_of_inputs];
+static int pow_inputs[number_of_inputs];
+static uint8_t ocv_index[64];
+static Val_t ocv_rows[3][51];
+static uint8_t ocv_codes_index[64];
+static uint16_t ocv_codes[51];
+static LcdHandle_t lcd_handle = nullptr;
+
+static
+void prepareInputs()
+{
+  uint32_t seed = 2022;
+  auto const uniform = [&seed]() -> double {
+    seed = seed * 1664525u + 1013904223u;
+    return (seed >> 8) / 16777216.0;
+  };
+  for (int i = 0; i < number_of_inputs; i++)
+  {
+    soc_inputs[i] = 100.0 * uniform();
+    ocv_inputs[i] = mySocOcvTable.get_y_by_x(soc_inputs[i]) + 0.01 * (uniform() - 0.5);
+    temperature_inputs[i] = 10.0 + 30.0 * uniform();
+    mV_inputs[i] = static_cast<int>(2500 + 1700 * uniform());
+    pow_inputs[i] = static_cast<int>(10 * uniform());
+  }
+  for (int r = 0; r < 3; r++)
+  {
+    for (int c = 0; c < 51; c++)
+    {
+      ocv_rows[r][c] = mySocOcvTable.get_y_by_x(2.0 * c) - 0.02 * (2 - r);
+    }
+  }
+  for (int c = 0; c < 51; c++)
+  {
+    ocv_codes[c] = encodeU16(ocv_rows[2][c], 2.50, 0.0001);
+  }
+  lcd_handle = new LiquidCrystal_I2C(0x27, LCD_WIDTH, LCD_HEIGHT);
+}
+
+static AscList const plain_table = { &ocv_rows[2], 0.00, 100.00 };
+static AscList const *indexed_table = nullptr;
+static Map2d<51> const *map_table = nullptr;
+static AscList const *plain_codes_table = nullptr;
+static AscList const *indexed_codes_table = nullptr;
+
+// `POW`: 4.5 multiplications in 64 bits for the exponents in [0, 9].
+static constexpr double estimatePow = 4.5 * (cost_mul64 + cost_step);
+static double benchPow(int const i)
+{
+  return POW(10, pow_inputs[i]);
+}
+// `AscList::get_x_by_y` by the binary search: 6 halvings of 51 entries.
+static constexpr double estimateAscListSearch = 6 * (2 * cost_fcmp + cost_step) + interpolate + parameter;
+static double benchAscListSearch(int const i)
+{
+  return plain_table.get_x_by_y(ocv_inputs[i]);
+}
+// `AscList::get_x_by_y` by the index: the bucket and 1.5 steps within it on average.
+static constexpr double estimateAscListIndex = 2 * cost_fcmp + cost_fadd + cost_fmul + cost_fconv + 1.5 * (cost_fcmp + cost_step) + interpolate + parameter;
+static double benchAscListIndex(int const i)
+{
+  return indexed_table->get_x_by_y(ocv_inputs[i]);
+}
+// `AscList::get_x_by_y_with_codes` by the binary search over integer codes.
+static constexpr double estimateAscListCodesSearch = encode + 6 * (4 + cost_step) + interpolate_codes + parameter;
+static double benchAscListCodesSearch(int const i)
+{
+  return plain_codes_table->get_x_by_y(ocv_inputs[i]);
+}
+// `AscList::get_x_by_y_with_codes` by the index over integer codes.
+static constexpr double estimateAscListCodesIndex = encode + 2 * cost_fconv + cost_fmul + 1.5 * (4 + cost_step) + interpolate_codes + parameter;
+static double benchAscListCodesIndex(int const i)
+{
+  return indexed_codes_table->get_x_by_y(ocv_inputs[i]);
+}
+// `AscList::get_y_by_x`: the uniform `xs` give the entry at once.
+static constexpr double estimateAscListForward = 2 * cost_fcmp + cost_fadd + cost_fmul + cost_fdiv + cost_fconv + cost_fcmp + interpolate;
+static double benchAscListForward(int const i)
+{
+  return mySocOcvTable.get_y_by_x(soc_inputs[i]);
+}
+// `Map2d::with_s_get_x_by_y`: the row parameter and 6 lazily interpolated steps.
+static constexpr double estimateMap2d = 2 * cost_fcmp + 2 * cost_fadd + cost_fmul + cost_fdiv + 2 * cost_fconv + 6 * map2d_step + interpolate + parameter;
+static double benchMap2d(int const i)
+{
+  return map_table->with_s_get_x_by_y(temperature_inputs[i], ocv_inputs[i]);
+}
+// `Map2d::get_x_by_y` on a kept row: 6 lazily interpolated steps.
+static constexpr double estimateMap2dRow = 6 * map2d_step + interpolate + parameter;
+static double benchMap2dRow(int const i)
+{
+  static Map2d<51>::Row const row = map_table->get_row_by_s(25.0);
+  return map_table->get_x_by_y(row, ocv_inputs[i]);
+}
+// `SizedFormatter::putInt`: 4 digits in 32 bits.
+static constexpr double estimatePutInt = 4 * digit32;
+static double benchPutInt(int const i)
+{
+  SizedFormatter<LCD_SECTION_LEN> formatter = { };
+  formatter.putInt(mV_inputs[i], 10);
+  return formatter.size();
+}
+// `LegacyFormatter::putInt`: the length by 4 multiplications, and then a `POW` per digit.
+static constexpr double estimatePutIntLegacy = 4 * (cost_mul64 + cost_step) + 4 * digit64legacy;
+static double benchPutIntLegacy(int const i)
+{
+  LegacyFormatter<LCD_SECTION_LEN> formatter = { };
+  formatter.putInt(mV_inputs[i], 10);
+  return formatter.front();
+}
+// `SizedFormatter::putDouble`: the split in 32 bits and 4 digits.
+static constexpr double estimatePutDouble = put_double;
+static double benchPutDouble(int const i)
+{
+  SizedFormatter<LCD_SECTION_LEN> formatter = { };
+  formatter.putDouble(soc_inputs[i], 2);
+  return formatter.size();
+}
+// `LegacyFormatter::putDouble`: the split in 64 bits and 4 digits by `POW`.
+static constexpr double estimatePutDoubleLegacy = cost_fmul + cost_fadd + cost_fconv + 2 * cost_mul64 + 2 * cost_div64 + 2 * (cost_mul64 + cost_step) + 4 * digit64legacy;
+static double benchPutDoubleLegacy(int const i)
+{
+  LegacyFormatter<LCD_SECTION_LEN> formatter = { };
+  formatter.putDouble(soc_inputs[i], 2);
+  return formatter.front();
+}
+// `LcdPrinter` of a screen: 3 `putDouble`s, 2 divisions, an integer and 64 characters.
+static constexpr double estimateLcdPrinter = 3 * put_double + 2 * cost_fdiv + 2 * digit32 + 64 * cost_step;
+static double benchLcdPrinter(int const i)
+{
+  LcdPrinter lcd = { lcd_handle };
+  lcd.print("B");
+  lcd.print(1);
+  lcd.print("=");
+  lcd.println(mV_inputs[i] / 1000.0);
+  lcd.print(" ");
+  lcd.print(soc_inputs[i]);
+  lcd.println("%");
+  lcd.print("I");
+  lcd.print("=");
+  lcd.println(soc_inputs[i] / 50.0);
+  return i;
+}
+
+static
+double measureNsPerOp(double (*const run)(int))
+{
+  using clock = std::chrono::steady_clock;
+  double volatile sink = 0.0;
+  long iterations = 0;
+  auto const beg = clock::now();
+  double elapsed = 0.0;
+
+  do
+  {
+    for (int i = 0; i < number_of_inputs; i++)
+    {
+      sink = sink + run(i);
+    }
+    iterations += number_of_inputs;
+    elapsed = std::chrono::duration<double, std::nano>(clock::now() - beg).count();
+  } while (elapsed < 2e8);
+  return elapsed / iterations;
+}
+
+int main(int const argc, char const *const *const argv)
+{
+  char const *const path = argc > 1 ? argv[1] : "_host_build/bench_results.csv";
+  FILE *const results = fopen(path, "w");
+
+  prepareInputs();
+  indexed_table = new AscList{ &ocv_rows[2], 0.00, 100.00, &ocv_index };
+  map_table = new Map2d<51>{ &ocv_rows, 0.00, 100.00, 10.00, 40.00 };
+  plain_codes_table = new AscList{ &ocv_codes, 2.50, 0.0001, 0.00, 100.00 };
+  indexed_codes_table = new AscList{ &ocv_codes, 2.50, 0.0001, 0.00, 100.00, &ocv_codes_index };
+
+  Benchmark const benchmarks[] =
+  { { "POW",                             benchPow,             estimatePow }
+  , { "AscList::get_y_by_x",             benchAscListForward,  estimateAscListForward }
+  , { "AscList::get_x_by_y(search)",     benchAscListSearch,   estimateAscListSearch }
+  , { "AscList::get_x_by_y(index)",      benchAscListIndex,    estimateAscListIndex }
+  , { "AscList::get_x_by_y(u16,search)", benchAscListCodesSearch, estimateAscListCodesSearch }
+  , { "AscList::get_x_by_y(u16,index)",  benchAscListCodesIndex, estimateAscListCodesIndex }
+  , { "Map2d::with_s_get_x_by_y",        benchMap2d,           estimateMap2d }
+  , { "Map2d::get_x_by_y(row)",          benchMap2dRow,        estimateMap2dRow }
+  , { "SizedFormatter::putInt",          benchPutInt,          estimatePutInt }
+  , { "SizedFormatter::putInt(legacy)",  benchPutIntLegacy,    estimatePutIntLegacy }
+  , { "SizedFormatter::putDouble",       benchPutDouble,       estimatePutDouble }
+  , { "SizedFormatter::putDouble(legacy)", benchPutDoubleLegacy, estimatePutDoubleLegacy }
+  , { "LcdPrinter(screen)",              benchLcdPrinter,      estimateLcdPrinter }
+  };
+
+  printf("%-36s %12s %12s %12s\n", "benchmark", "ns/op", "avr cyc est", "avr us est");
+  if (results)
+  {
+    fprintf(results, "benchmark,ns_per_op,avr_cycles_estimate,avr_us_estimate\n");
+  }
+  for (int i = 0; i < static_cast<int>(LENGTH(benchmarks)); i++)
+  {
+    double const ns = measureNsPerOp(benchmarks[i].run);
+    double const us = benchmarks[i].avr_cycles_estimate / 16.0;
+    printf("%-36s %12.1f %12.0f %12.1f\n", benchmarks[i].name, ns, benchmarks[i].avr_cycles_estimate, us);
+    if (results)
+    {
+      fprintf(results, "%s,%.2f,%.0f,%.2f\n", benchmarks[i].name, ns, benchmarks[i].avr_cycles_estimate, us);
+    }
+  }
+  if (results)
+  {
+    fclose(results);
+  }
+  return 0;
+}
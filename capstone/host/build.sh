@@ -0,0 +1,40 @@
+#!/bin/sh
+# Builds the host targets of the sketch into the directory `$1` (default: `_host_build`).
+# Then it reports the literals of the sketch which would take the SRAM on AVR.
+# Usage
+# > sh capstone/host/build.sh [output-directory]
+set -e
+host=$(cd "$(dirname "$0")" && pwd)
+sketch=$(dirname "$host")
+out=${1:-_host_build}
+CXX=${CXX:-g++}
+WARNINGS="-Wall -Wextra"
+
+rm -rf "$out/src"
+mkdir -p "$out/src"
+cp "$sketch"/*.hpp "$sketch"/*.h "$sketch"/*.cpp "$out/src/"
+for ino in "$sketch"/*.ino; do
+  cp "$ino" "$out/src/$(basename "$ino" .ino).cpp"
+done
+# avr-gcc 7 accepts designators in constructor calls, e.g. `{ .pinId = Apin(0) }`, but GCC >= 8 rejects them.
+sed -E -i 's/(\{|,)( *)\.[A-Za-z_][A-Za-z_0-9]* *= /\1\2/g' "$out"/src/*
+
+$CXX -std=gnu++11 -O2 $WARNINGS -I"$out/src" -I"$host" "$out"/src/*.cpp "$host/hal.cpp" "$host/simulation.cpp" -o "$out/simulation"
+$CXX -std=gnu++11 -O2 $WARNINGS -I"$out/src" -I"$host" "$out"/src/*.cpp "$host/hal.cpp" "$host/bench.cpp" -o "$out/bench"
+
+rm -rf "$out/src-ekf"
+cp -r "$out/src" "$out/src-ekf"
+sed -E -i 's/^(#define SOC_ESTIMATOR +)SOC_COULOMB/\1SOC_EKF/' "$out/src-ekf/version.h"
+$CXX -std=gnu++11 -O2 $WARNINGS -I"$out/src-ekf" -I"$host" "$out"/src-ekf/*.cpp "$host/hal.cpp" "$host/simulation.cpp" -o "$out/simulation-ekf"
+$CXX -std=c++11 -O2 $WARNINGS "$host/telemetry2csv.cpp" -o "$out/telemetry2csv"
+
+# Every literal outside `PROGMEM` would be copied into the 2KB SRAM on AVR, hence they are reported here.
+rm -rf "$out/obj"
+mkdir -p "$out/obj"
+for src in "$out"/src/*.cpp; do
+  $CXX -std=gnu++11 -Os -c -I"$out/src" -I"$host" "$src" -o "$out/obj/$(basename "$src" .cpp).o"
+done
+size -A "$out"/obj/*.o | awk '
+  /^\.rodata\.str/ { sram += $2 }
+  /^\.progmem/     { flash += $2 }
+  END { printf "literals of the sketch: %d bytes in SRAM, %d bytes of PROGMEM in flash\n", sram, flash }'
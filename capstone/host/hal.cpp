@@ -0,0 +1,515 @@
+/* <CAPSTONE PROJECT>
+** ===============================================================================
+** MEMBER        | AFFILIATION                                                   |
+** ===============================================================================
+** Hwan-hee Jeon | School of Mechanical Engineering, Chonnam National University |
+** Hak-jung Im   | School of Mechanical Engineering, Chonnam National University |
+** Ki-jeong Lim  | School of Mechanical Engineering, Chonnam National University |
+** ===============================================================================
+*/
+
+#include <stdio.h>
+#include "hal.hpp"
+#include "avr/eeprom.h"
+#include "Wire.h"
+#include "LiquidCrystal_I2C.h"
+#include "capstone.hpp"
+
+namespace Sim {
+
+  constexpr uint8_t zener_pin       = A0;
+  constexpr uint8_t tap_pins[]      = { A1, A2 };
+  constexpr uint8_t current_pin     = A3;
+  constexpr uint8_t discharger_pins[] = { 2, 3 };
+  constexpr uint8_t powerIn_pin     = 13;
+  constexpr uint8_t lcd_address     = 0x27;
+  constexpr double  zenerV          = 2.48;
+  constexpr double  bleedR          = 5.0;
+  constexpr double  wireR           = 0.2;
+  constexpr double  noiseCounts     = 1.0;
+  constexpr double  currentNoiseCounts = 2.0;
+  constexpr uint64_t conversion_us  = 112;
+  constexpr uint64_t adc_conversion_us = 104;
+  constexpr uint64_t clock_read_us  = 2;
+  constexpr uint64_t settle_us      = 10000;
+  constexpr uint64_t eeprom_write_us = 3400;
+
+  CellModel cells[number_of_cells] =
+  { { .capacity_mAh = 3317.0, .soc = 0.30, .R0 = 0.05 }
+  , { .capacity_mAh = 3250.0, .soc = 0.36, .R0 = 0.06 }
+  };
+  double Vcc = 4.96;
+  double chargerI = 1.00;
+  double chargerV = 8.40;
+  double sensorOffsetA = -0.26;
+  double faultV = 0.0;
+  bool echo_serial = false;
+  unsigned long serial_bytes = 0;
+  unsigned long lcd_writes = 0;
+  unsigned long eeprom_writes = 0;
+  uint64_t power_cut_time = 0;
+
+  static uint64_t time_us = 0;
+  static uint64_t pending_us = 0;
+  static bool pins[32] = { };
+  static uint32_t seed = 12345;
+  static uint8_t eeprom[E2END + 1];
+  static bool eeprom_erased = false;
+  static uint64_t eeprom_ready_time = 0;
+  static bool interrupts_enabled = true;
+  static bool adc_converting = false;
+  static bool adc_interrupt_pending = false;
+  static uint64_t adc_done_time = 0;
+
+  static
+  uint8_t *eepromCellOf(void const *const address)
+  {
+    uintptr_t const idx = reinterpret_cast<uintptr_t>(address);
+
+    if (not eeprom_erased)
+    {
+      memset(eeprom, 0xFF, sizeof(eeprom));
+      eeprom_erased = true;
+    }
+    return idx < sizeof(eeprom) ? &eeprom[idx] : nullptr;
+  }
+
+  static
+  double noise()
+  {
+    double sum = 0.0;
+    for (int i = 0; i < 4; i++)
+    {
+      seed = seed * 1664525u + 1013904223u;
+      sum += (seed >> 8) / 16777216.0 - 0.5;
+    }
+    return sum * noiseCounts * 1.7320508;
+  }
+
+  static
+  double ocvOf(int const cell_no)
+  {
+    return mySocOcvTable.get_y_by_x(100.0 * cells[cell_no].soc);
+  }
+
+  uint64_t now()
+  {
+    return time_us;
+  }
+
+  uint32_t virtualMicros()
+  {
+    advance(clock_read_us);
+    return static_cast<uint32_t>(time_us);
+  }
+
+  bool isPinHigh(uint8_t const pin)
+  {
+    return pin < LENGTH(pins) && pins[pin];
+  }
+
+  double packCurrent()
+  {
+    double sum_of_ocvs = 0.0, sum_of_Rs = 0.0;
+
+    if (not isPinHigh(powerIn_pin))
+    {
+      return 0.0;
+    }
+    for (int i = 0; i < number_of_cells; i++)
+    {
+      sum_of_ocvs += ocvOf(i);
+      sum_of_Rs += cells[i].R0 + wireR;
+    }
+    if (sum_of_ocvs + chargerI * sum_of_Rs <= chargerV)
+    {
+      return chargerI;
+    }
+    return sum_of_ocvs < chargerV ? (chargerV - sum_of_ocvs) / sum_of_Rs : 0.0;
+  }
+
+  double cellCurrent(int const cell_no)
+  {
+    double I = packCurrent();
+
+    if (isPinHigh(discharger_pins[cell_no]))
+    {
+      I -= ocvOf(cell_no) / bleedR;
+    }
+    return I;
+  }
+
+  double cellVoltage(int const cell_no)
+  {
+    return ocvOf(cell_no) + cellCurrent(cell_no) * cells[cell_no].R0;
+  }
+
+  static
+  void settle()
+  {
+    double const hours = pending_us / 3600e6;
+
+    for (int i = 0; i < number_of_cells; i++)
+    {
+      cells[i].soc += 1000.0 * cellCurrent(i) * hours / cells[i].capacity_mAh;
+    }
+    pending_us = 0;
+  }
+
+  static
+  void elapse(uint64_t const until_us)
+  {
+    pending_us += until_us - time_us;
+    time_us = until_us;
+    if (pending_us >= settle_us)
+    {
+      settle();
+    }
+  }
+
+  static
+  double channelVoltage(uint8_t const pin)
+  {
+    double V = 0.0;
+
+    if (pin == zener_pin)
+    {
+      V = zenerV;
+    }
+    else if (pin == current_pin)
+    {
+      V = 0.5 * Vcc + 0.1 * (packCurrent() + sensorOffsetA);
+    }
+    else
+    {
+      double tapV = faultV;
+      for (int i = 0; i < number_of_cells; i++)
+      {
+        tapV += cellVoltage(i) + cellCurrent(i) * wireR;
+        if (pin == tap_pins[i])
+        {
+          V = tapV / 10.0;
+        }
+      }
+    }
+    return V;
+  }
+
+  static
+  int countsOf(uint8_t const pin)
+  {
+    double const V = channelVoltage(pin);
+    int const counts = floor(V / Vcc * 1024.0 + noise() * (pin == current_pin ? currentNoiseCounts / noiseCounts : 1.0) + 0.5);
+    return counts < 0 ? 0 : counts > 1023 ? 1023 : counts;
+  }
+
+  void startAdc()
+  {
+    if (not adc_converting)
+    {
+      adc_converting = true;
+      adc_done_time = time_us + adc_conversion_us;
+    }
+  }
+
+  static
+  void completeAdc()
+  {
+    adc_converting = false;
+    ADC = countsOf(A0 + (ADMUX & 0x07));
+    ADCSRA.bits &= ~(1 << ADSC);
+    if (ADCSRA.bits & (1 << ADIE))
+    {
+      if (interrupts_enabled)
+      {
+        ADC_vect();
+      }
+      else
+      {
+        adc_interrupt_pending = true;
+      }
+    }
+  }
+
+  void advance(uint64_t const us)
+  {
+    uint64_t const until_us = time_us + us;
+
+    while (adc_converting && adc_done_time <= until_us)
+    {
+      elapse(adc_done_time);
+      completeAdc();
+    }
+    elapse(until_us);
+  }
+}
+
+unsigned long millis()
+{
+  Sim::advance(Sim::clock_read_us);
+  return Sim::now() / 1000;
+}
+
+unsigned long micros()
+{
+  Sim::advance(Sim::clock_read_us);
+  return Sim::now();
+}
+
+void delay(unsigned long const ms)
+{
+  Sim::advance(1000ull * ms);
+}
+
+void delayMicroseconds(unsigned int const us)
+{
+  Sim::advance(us);
+}
+
+void pinMode(uint8_t, uint8_t)
+{
+}
+
+void digitalWrite(uint8_t const pin, uint8_t const val)
+{
+  if (pin < LENGTH(Sim::pins))
+  {
+    Sim::settle();
+    if (pin == Sim::powerIn_pin && Sim::pins[pin] && val == LOW)
+    {
+      Sim::power_cut_time = Sim::now();
+    }
+    Sim::pins[pin] = val != LOW;
+  }
+}
+
+int digitalRead(uint8_t const pin)
+{
+  return Sim::isPinHigh(pin) ? HIGH : LOW;
+}
+
+int analogRead(uint8_t const pin)
+{
+  Sim::advance(Sim::conversion_us);
+  return Sim::countsOf(pin);
+}
+
+bool eeprom_is_ready()
+{
+  return Sim::now() >= Sim::eeprom_ready_time;
+}
+
+uint8_t eeprom_read_byte(uint8_t const *const address)
+{
+  uint8_t const *const cell = Sim::eepromCellOf(address);
+  return cell ? *cell : 0xFF;
+}
+
+void eeprom_read_block(void *const dst, void const *const src, size_t const len)
+{
+  for (size_t i = 0; i < len; i++)
+  {
+    static_cast<uint8_t *>(dst)[i] = eeprom_read_byte(static_cast<uint8_t const *>(src) + i);
+  }
+}
+
+void eeprom_update_byte(uint8_t *const address, uint8_t const val)
+{
+  uint8_t *const cell = Sim::eepromCellOf(address);
+
+  if (cell && *cell != val)
+  {
+    if (not eeprom_is_ready())
+    {
+      Sim::advance(Sim::eeprom_ready_time - Sim::now());
+    }
+    *cell = val;
+    Sim::eeprom_writes++;
+    Sim::eeprom_ready_time = Sim::now() + Sim::eeprom_write_us;
+  }
+}
+
+void analogWrite(uint8_t const pin, int const val)
+{
+  digitalWrite(pin, val > 0 ? HIGH : LOW);
+}
+
+void noInterrupts()
+{
+  Sim::interrupts_enabled = false;
+}
+
+void interrupts()
+{
+  Sim::interrupts_enabled = true;
+  if (Sim::adc_interrupt_pending)
+  {
+    Sim::adc_interrupt_pending = false;
+    ADC_vect();
+  }
+}
+
+uint8_t ADMUX = 0;
+AdcControlRegister ADCSRA = { .bits = 0 };
+uint16_t ADC = 0;
+
+AdcControlRegister::operator uint8_t()
+{
+  if (bits & (1 << ADSC))
+  {
+    Sim::advance(1);
+  }
+  return bits;
+}
+AdcControlRegister &AdcControlRegister::operator=(uint8_t const val)
+{
+  bits = val;
+  if ((bits & (1 << ADEN)) && (bits & (1 << ADSC)))
+  {
+    Sim::startAdc();
+  }
+  return *this;
+}
+AdcControlRegister &AdcControlRegister::operator|=(uint8_t const val)
+{
+  return *this = bits | val;
+}
+AdcControlRegister &AdcControlRegister::operator&=(uint8_t const val)
+{
+  bits &= val;
+  return *this;
+}
+
+void HardwareSerial::begin(unsigned long const baud)
+{
+  this->baud = baud;
+  queued = 0;
+  drained_time = Sim::now();
+}
+void HardwareSerial::end()
+{
+}
+HardwareSerial::operator bool() const
+{
+  return true;
+}
+// The TX buffer of the AVR core holds 63 characters, and the UART sends a character of 10 bits per `10 / baud` seconds.
+void HardwareSerial::drain()
+{
+  uint64_t const us_per_char = baud > 0 ? 10000000ull / baud : 0;
+  uint64_t const sent = us_per_char > 0 ? (Sim::now() - drained_time) / us_per_char : queued;
+
+  if (sent >= static_cast<uint64_t>(queued))
+  {
+    queued = 0;
+    drained_time = Sim::now();
+  }
+  else
+  {
+    queued -= static_cast<int>(sent);
+    drained_time += sent * us_per_char;
+  }
+}
+int HardwareSerial::availableForWrite()
+{
+  this->drain();
+  return 63 - queued;
+}
+size_t HardwareSerial::write(uint8_t const ch)
+{
+  // Like the AVR core, it blocks until the TX buffer has room.
+  while (this->availableForWrite() <= 0)
+  {
+    Sim::advance(10000000ull / baud);
+  }
+  queued++;
+  Sim::serial_bytes++;
+  if (Sim::echo_serial)
+  {
+    fputc(ch, stderr);
+  }
+  return 1;
+}
+void HardwareSerial::flush()
+{
+}
+void HardwareSerial::print(char const *const str)
+{
+  for (char const *p_ch = str; *p_ch != '\0'; p_ch++)
+  {
+    this->write(*p_ch);
+  }
+}
+void HardwareSerial::println(char const *const str)
+{
+  this->print(str);
+  this->print("\r\n");
+}
+
+HardwareSerial Serial;
+
+void TwoWire::begin()
+{
+}
+void TwoWire::end()
+{
+}
+void TwoWire::beginTransmission(uint8_t const adr)
+{
+  address = adr;
+}
+uint8_t TwoWire::endTransmission(uint8_t)
+{
+  return address == Sim::lcd_address ? 0 : 2;
+}
+
+TwoWire Wire;
+
+LiquidCrystal_I2C::LiquidCrystal_I2C(uint8_t, uint8_t const lcd_cols, uint8_t const lcd_rows)
+  : cols{ lcd_cols }
+  , rows{ lcd_rows }
+  , cursor_col{ 0 }
+  , cursor_row{ 0 }
+{
+}
+void LiquidCrystal_I2C::init()
+{
+  this->clear();
+}
+void LiquidCrystal_I2C::backlight()
+{
+}
+void LiquidCrystal_I2C::noBacklight()
+{
+}
+void LiquidCrystal_I2C::clear()
+{
+  Sim::lcd_writes += cols * rows;
+  cursor_col = 0;
+  cursor_row = 0;
+}
+void LiquidCrystal_I2C::setCursor(uint8_t const col, uint8_t const row)
+{
+  Sim::lcd_writes++;
+  cursor_col = col;
+  cursor_row = row;
+}
+size_t LiquidCrystal_I2C::write(uint8_t)
+{
+  Sim::lcd_writes++;
+  cursor_col++;
+  return 1;
+}
+void LiquidCrystal_I2C::print(char const *const str)
+{
+  for (char const *p_ch = str; *p_ch != '\0'; p_ch++)
+  {
+    this->write(*p_ch);
+  }
+}
+void LiquidCrystal_I2C::print(int const num)
+{
+  char str[12] = { };
+  snprintf(str, sizeof(str), "%d", num);
+  this->print(str);
+}
@@ -0,0 +1,79 @@
+/* <CAPSTONE PROJECT>
+** ===============================================================================
+** MEMBER        | AFFILIATION                                                   |
+** ===============================================================================
+** Hwan-hee Jeon | School of Mechanical Engineering, Chonnam National University |
+** Hak-jung Im   | School of Mechanical Engineering, Chonnam National University |
+** Ki-jeong Lim  | School of Mechanical Engineering, Chonnam National University |
+** ===============================================================================
+*/
+
+// include-guard
+#ifndef CAPSTONE_HOST_HAL
+#define CAPSTONE_HOST_HAL
+
+#include "Arduino.h"
+
+// implemented in "hal.cpp"
+namespace Sim {
+
+  struct CellModel {
+    double capacity_mAh;
+    double soc;
+    double R0;
+  };
+
+  constexpr int number_of_cells = 2;
+
+  extern CellModel cells[number_of_cells];
+  extern double Vcc;
+  extern double chargerI;
+  extern double chargerV;
+  extern double sensorOffsetA;
+  extern double faultV;
+  extern bool echo_serial;
+  extern unsigned long serial_bytes;
+  extern unsigned long lcd_writes;
+  extern unsigned long eeprom_writes;
+  extern uint64_t power_cut_time;
+
+  uint64_t now();
+  uint32_t virtualMicros();
+  void advance(uint64_t us);
+  void startAdc();
+  bool isPinHigh(uint8_t pin);
+  double packCurrent();
+  double cellCurrent(int cell_no);
+  double cellVoltage(int cell_no);
+}
+/* Comments
+** [Sim]
+** 1. The simulated board and pack behind the stand-ins of "Arduino.h", "Wire.h" and "LiquidCrystal_I2C.h".
+** 2. Wiring, which follows `MAJOR_VERSION == 2` of "capstone.ino"
+**    > A0 <- TL431 reference (2.48V)
+**    > A1 <- tap of cell 1 through 18k/2k divider
+**    > A2 <- tap of cell 2 through 18k/2k divider
+**    > A3 <- ACS712 output (Vcc / 2 + 0.1V/A)
+**    >  2 -> discharger of cell 1 (5Ohm bleed resistor)
+**    >  3 -> discharger of cell 2 (5Ohm bleed resistor)
+**    > 13 -> power-in switch of the CC-CV charger
+** [Sim::sensorOffsetA]
+** 1. The offset of the ACS712 in amperes, which `BMS::Iin_calibration` cancels when it is `-0.26`.
+** [Sim::CellModel]
+** 1. A cell, whose terminal voltage is `OCV(soc) + I * R0`,
+**    where `OCV` is `mySocOcvTable`.
+** [Sim::now]
+** 1. The virtual time in microseconds.
+** [Sim::virtualMicros]
+** 1. The virtual time truncated to 32 bits, which is a source for `setClockSource`.
+** 2. Reading it takes `clock_read_us` of the virtual time, as `micros` does.
+** [Sim::advance]
+** 1. A function to advance the virtual time, integrating the charge of every cell.
+** 2. The conversions of the ADC which end meanwhile are completed in order, each at its own time.
+** [Sim::faultV]
+** 1. A step added to the voltage of the bottom cell, as seen by the taps, to inject a fault.
+** [Sim::power_cut_time]
+** 1. The virtual time when the power-in switch was last opened.
+*/
+
+#endif
@@ -0,0 +1,229 @@
+/* <CAPSTONE PROJECT>
+** ===============================================================================
+** MEMBER        | AFFILIATION                                                   |
+** ===============================================================================
+** Hwan-hee Jeon | School of Mechanical Engineering, Chonnam National University |
+** Hak-jung Im   | School of Mechanical Engineering, Chonnam National University |
+** Ki-jeong Lim  | School of Mechanical Engineering, Chonnam National University |
+** ===============================================================================
+*/
+
+/* Comments
+** [simulation]
+** 1. A host-side simulation, which runs `setup` and `loop` of "capstone.ino" against `Sim`.
+** 2. Usage
+** > sh capstone/host/build.sh
+** > ./_host_build/simulation [hours = 3] [--serial] [--offset A] [--charger A] [--restart hours] [--fault hours (oc|ov|uv)] > trace.csv
+** > ./_host_build/simulation --graph
+** - Notes
+**   [A] `--serial` echoes the serial port of the sketch to `stderr`.
+**   [B] `--offset A` sets `Sim::sensorOffsetA`,
+**       e.g. `--offset -0.20` leaves an error of 60mA after `BMS::Iin_calibration`.
+**   [C] `--restart hours` stops the ADC sampler and runs `setup` again at the given time,
+**       which resumes from the checkpoint in the simulated EEPROM.
+**   [D] A line of CSV is printed every simulated minute,
+**       and a summary is printed to `stderr` at the end,
+**       including the RMS and the maximum errors of the SOC estimated by the sketch.
+**   [E] Only `MAJOR_VERSION == 2` is supported.
+**   [F] `_host_build/simulation-ekf` is built with `SOC_ESTIMATOR == SOC_EKF`.
+**   [G] `clockMicros` reads `Sim::virtualMicros`, and the virtual time jumps to the next deadline of `BMS::scheduler`
+**       whenever no task is due, hence idle time costs nothing and the 32-bit clock wraps around in runs over 71 minutes.
+**   [H] `--graph` prints the transition table of `BMS::lifecycle` to `stderr` and exits.
+**   [I] `--fault hours kind` injects a fault at the given time:
+**       `oc` lets the charger push 3A, `ov` raises the bottom tap by 1.2V, and `uv` lowers it by 2.0V.
+**       The summary reports the trip latency, from the injection to the opening of the power-in switch,
+**       which `BMS::guard` bounds by `TRIP_STRIKES` rounds of the ADC sampler.
+**   [J] Without `--fault`, the summary reports the SOC of the pack when the power-in switch is first opened,
+**       and the simulation fails with the exit code `1` if it is below `charged_soc_min`.
+**   [K] `--charger A` sets `Sim::chargerI`, the current of the charger until its voltage is reached.
+*/
+
+#include <chrono>
+#include <stdio.h>
+#include "hal.hpp"
+#include "capstone.hpp"
+
+void setup();
+void loop();
+
+namespace BMS {
+  extern CellStates<Sim::number_of_cells> cell_states;
+  extern Scheduler scheduler;
+  void dumpLifecycle();
+}
+
+static
+void printHeader()
+{
+  printf("time_s,packI_A");
+  for (int i = 0; i < Sim::number_of_cells; i++)
+  {
+    printf(",soc%d_true,soc%d_bms,V%d_true_V,V%d_bms_V,discharger%d", i, i, i, i, i);
+  }
+  printf("\n");
+}
+
+static
+void injectFault(char const *const kind)
+{
+  if (strcmp(kind, "oc") == 0)
+  {
+    Sim::chargerI = 3.0;
+    Sim::chargerV = 12.0;
+  }
+  else if (strcmp(kind, "ov") == 0)
+  {
+    Sim::faultV = 1.2;
+  }
+  else if (strcmp(kind, "uv") == 0)
+  {
+    Sim::faultV = -2.0;
+  }
+}
+
+static constexpr double charged_soc_min = 95.0;
+
+static double sum_of_sq_errs[Sim::number_of_cells] = { };
+static double max_errs[Sim::number_of_cells] = { };
+static int number_of_traces[Sim::number_of_cells] = { };
+
+static
+void printTrace()
+{
+  printf("%.0f,%.3f", Sim::now() / 1e6, Sim::packCurrent());
+  for (int i = 0; i < Sim::number_of_cells; i++)
+  {
+    double const soc_bms = static_cast<double>(100.0 * BMS::cell_states.Qs[i] / Sim::cells[i].capacity_mAh);
+    double const err = fabs(soc_bms - 100.0 * Sim::cells[i].soc);
+
+    printf(",%.2f,%.2f,%.3f,%.3f,%d", 100.0 * Sim::cells[i].soc, soc_bms, Sim::cellVoltage(i), BMS::cell_states.cellVs[i] / 1000.0, Sim::isPinHigh(2 + i));
+    if (BMS::cell_states.Qs[i] > 0)
+    {
+      sum_of_sq_errs[i] += err * err;
+      number_of_traces[i]++;
+    }
+    if (BMS::cell_states.Qs[i] > 0 && max_errs[i] < err)
+    {
+      max_errs[i] = err;
+    }
+  }
+  printf("\n");
+}
+
+int main(int const argc, char const *const *const argv)
+{
+  double hours = 3.0;
+  double restart_hours = -1.0;
+  double fault_hours = -1.0;
+  char const *fault_kind = nullptr;
+  uint64_t fault_time = 0;
+  uint64_t next_trace = 0;
+  uint64_t charged_time = 0;
+  double charged_soc = 0.0;
+  auto const beg = std::chrono::steady_clock::now();
+
+  for (int i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "--serial") == 0)
+    {
+      Sim::echo_serial = true;
+    }
+    else if (strcmp(argv[i], "--offset") == 0 && i + 1 < argc)
+    {
+      Sim::sensorOffsetA = atof(argv[++i]);
+    }
+    else if (strcmp(argv[i], "--charger") == 0 && i + 1 < argc)
+    {
+      Sim::chargerI = atof(argv[++i]);
+    }
+    else if (strcmp(argv[i], "--graph") == 0)
+    {
+      Sim::echo_serial = true;
+      BMS::dumpLifecycle();
+      return 0;
+    }
+    else if (strcmp(argv[i], "--restart") == 0 && i + 1 < argc)
+    {
+      restart_hours = atof(argv[++i]);
+    }
+    else if (strcmp(argv[i], "--fault") == 0 && i + 2 < argc)
+    {
+      fault_hours = atof(argv[++i]);
+      fault_kind = argv[++i];
+    }
+    else
+    {
+      hours = atof(argv[i]);
+    }
+  }
+
+  printHeader();
+  setClockSource(Sim::virtualMicros);
+  setup();
+  while (Sim::now() < hours * 3600e6)
+  {
+    if (restart_hours >= 0.0 && Sim::now() >= restart_hours * 3600e6)
+    {
+      uint64_t const cut_time = Sim::power_cut_time;
+
+      restart_hours = -1.0;
+      endAdcSampler();
+      setup();
+      Sim::power_cut_time = cut_time;
+    }
+    if (fault_hours >= 0.0 && Sim::now() >= fault_hours * 3600e6)
+    {
+      fault_hours = -1.0;
+      fault_time = Sim::now();
+      Sim::power_cut_time = 0;
+      injectFault(fault_kind);
+    }
+    loop();
+    if (not fault_kind && charged_time == 0 && Sim::power_cut_time > 0)
+    {
+      double sum_of_charges = 0.0, sum_of_capacities = 0.0;
+
+      for (int i = 0; i < Sim::number_of_cells; i++)
+      {
+        sum_of_charges += Sim::cells[i].soc * Sim::cells[i].capacity_mAh;
+        sum_of_capacities += Sim::cells[i].capacity_mAh;
+      }
+      charged_time = Sim::power_cut_time;
+      charged_soc = 100.0 * sum_of_charges / sum_of_capacities;
+    }
+    Sim::advance(BMS::scheduler.untilNextDue());
+    if (Sim::now() >= next_trace)
+    {
+      printTrace();
+      next_trace += 60000000ull;
+    }
+  }
+
+  double const wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - beg).count();
+  fprintf(stderr, "simulated %.2f h in %.2f s (x%.0f), serial bytes = %lu, serial drops = %lu, lcd writes = %lu, eeprom writes = %lu\n", Sim::now() / 3600e6, wall, Sim::now() / 1e6 / wall, Sim::serial_bytes, droppedSerial(), Sim::lcd_writes, Sim::eeprom_writes);
+  for (int i = 0; i < Sim::number_of_cells; i++)
+  {
+    fprintf(stderr, "cell %d: soc error rms = %.2f%%, max = %.2f%%\n", i, sqrt(sum_of_sq_errs[i] / (number_of_traces[i] > 0 ? number_of_traces[i] : 1)), max_errs[i]);
+  }
+  if (fault_kind && fault_time > 0)
+  {
+    if (Sim::power_cut_time >= fault_time)
+    {
+      fprintf(stderr, "fault %s at %.6f s: tripped after %lu us\n", fault_kind, fault_time / 1e6, static_cast<unsigned long>(Sim::power_cut_time - fault_time));
+    }
+    else
+    {
+      fprintf(stderr, "fault %s at %.6f s: not tripped\n", fault_kind, fault_time / 1e6);
+    }
+  }
+  if (charged_time > 0)
+  {
+    fprintf(stderr, "power cut at %.0f s: soc of the pack = %.2f%%\n", charged_time / 1e6, charged_soc);
+    if (charged_soc < charged_soc_min)
+    {
+      fprintf(stderr, "FAIL: the charging stopped below %.0f%%\n", charged_soc_min);
+      return 1;
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,205 @@
+/* <CAPSTONE PROJECT>
+** ===============================================================================
+** MEMBER        | AFFILIATION                                                   |
+** ===============================================================================
+** Hwan-hee Jeon | School of Mechanical Engineering, Chonnam National University |
+** Hak-jung Im   | School of Mechanical Engineering, Chonnam National University |
+** Ki-jeong Lim  | School of Mechanical Engineering, Chonnam National University |
+** ===============================================================================
+*/
+
+/* Comments
+** [telemetry2csv]
+** 1. A host-side decoder of `TelemetryFrame`s, which prints them as CSV.
+** 2. Usage
+** > g++ -std=c++11 -O2 -o telemetry2csv capstone/host/telemetry2csv.cpp
+** > stty -F /dev/ttyACM0 9600 raw && ./telemetry2csv < /dev/ttyACM0 > log.csv
+** 3. Layout of the payload of the type `0x01`
+**    > type(u8) | time[ms](u32) | arduino5V[mV](i16) | Iin[mA](i16) | n(u8)
+**    > | cellVs[mV](i16 x n) | Qs[uAh](i32 x n) | pins(u16)
+**    where the bit `0` of `pins` is `powerIn_pin` and the bit `i + 1` is `cells[i].DISCHARGER_pin`.
+** 4. Layout of the payload of the type `0x02`, which is printed to `stderr`
+**    > type(u8) | time[ms](u32) | m(u8) | (pin(u8) | window(u16) | variance[counts^2 / 256](u16)) x m
+** 5. Bytes outside of valid frames (e.g. text lines of `sout`) are skipped.
+*/
+
+#include <cstdint>
+#include <cstdio>
+
+static
+uint16_t CRC16(uint8_t const *const bytes, int const len, uint16_t crc = 0xFFFF)
+{
+  for (int i = 0; i < len; i++)
+  {
+    crc ^= static_cast<uint16_t>(bytes[i]) << 8;
+    for (int bit = 0; bit < 8; bit++)
+    {
+      crc = (crc & 0x8000) ? ((crc << 1) ^ 0x1021) : (crc << 1);
+    }
+  }
+  return crc;
+}
+
+class PayloadReader {
+  uint8_t const *const bytes;
+  int const len;
+  int cnt;
+public:
+  PayloadReader(uint8_t const *const _bytes, int const _len)
+    : bytes{ _bytes }
+    , len{ _len }
+    , cnt{ 0 }
+  {
+  }
+  bool isOkay() const
+  {
+    return cnt <= len;
+  }
+  uint32_t getU(int const size)
+  {
+    uint32_t val = 0;
+    for (int i = 0; i < size; i++, cnt++)
+    {
+      if (cnt < len)
+      {
+        val |= static_cast<uint32_t>(bytes[cnt]) << (8 * i);
+      }
+    }
+    return val;
+  }
+  int16_t getI16()
+  {
+    return static_cast<int16_t>(this->getU(2));
+  }
+  int32_t getI32()
+  {
+    return static_cast<int32_t>(this->getU(4));
+  }
+};
+
+static
+void printFrame(uint8_t const *const payload, int const len)
+{
+  static int number_of_cells_in_header = -1;
+  PayloadReader reader = { payload, len };
+  uint8_t const type = reader.getU(1);
+
+  if (type == 0x01)
+  {
+    uint32_t const time = reader.getU(4);
+    int16_t const arduino5V = reader.getI16();
+    int16_t const Iin = reader.getI16();
+    int const n = reader.getU(1);
+    int16_t cellVs[16] = { };
+    int32_t Qs[16] = { };
+    uint16_t pins = 0;
+
+    if (n > 16)
+    {
+      return;
+    }
+    for (int i = 0; i < n; i++)
+    {
+      cellVs[i] = reader.getI16();
+    }
+    for (int i = 0; i < n; i++)
+    {
+      Qs[i] = reader.getI32();
+    }
+    pins = reader.getU(2);
+    if (not reader.isOkay())
+    {
+      return;
+    }
+    if (number_of_cells_in_header != n)
+    {
+      number_of_cells_in_header = n;
+      std::printf("time_ms,arduino5V_V,Iin_A");
+      for (int i = 0; i < n; i++)
+      {
+        std::printf(",cellV%d_V", i);
+      }
+      for (int i = 0; i < n; i++)
+      {
+        std::printf(",Q%d_mAh", i);
+      }
+      std::printf(",powerIn");
+      for (int i = 0; i < n; i++)
+      {
+        std::printf(",discharger%d", i);
+      }
+      std::printf("\n");
+    }
+    std::printf("%lu,%.3f,%.3f", static_cast<unsigned long>(time), arduino5V / 1000.0, Iin / 1000.0);
+    for (int i = 0; i < n; i++)
+    {
+      std::printf(",%.3f", cellVs[i] / 1000.0);
+    }
+    for (int i = 0; i < n; i++)
+    {
+      std::printf(",%.3f", Qs[i] / 1000.0);
+    }
+    for (int i = 0; i <= n; i++)
+    {
+      std::printf(",%d", (pins >> i) & 1);
+    }
+    std::printf("\n");
+  }
+  else if (type == 0x02)
+  {
+    uint32_t const time = reader.getU(4);
+    int const m = reader.getU(1);
+
+    for (int i = 0; i < m; i++)
+    {
+      int const pin = reader.getU(1);
+      int const window = reader.getU(2);
+      int const variance = reader.getU(2);
+
+      if (reader.isOkay())
+      {
+        std::fprintf(stderr, "adc,%lu,%d,%d,%.3f\n", static_cast<unsigned long>(time), pin, window, variance / 256.0);
+      }
+    }
+  }
+}
+
+int main()
+{
+  uint8_t frame[2 + 1 + 255 + 2] = { };
+  int cnt = 0;
+  int ch = EOF;
+  unsigned long number_of_bad_frames = 0;
+
+  while ((ch = std::getchar()) != EOF)
+  {
+    frame[cnt++] = ch;
+    if (cnt == 1 && ch != 0xA5)
+    {
+      cnt = 0;
+      continue;
+    }
+    if (cnt == 2 && ch != 0x5A)
+    {
+      cnt = ch == 0xA5 ? 1 : 0;
+      continue;
+    }
+    if (cnt >= 3 && cnt == 3 + frame[2] + 2)
+    {
+      int const len = frame[2];
+      uint16_t const crc = frame[3 + len] | (frame[3 + len + 1] << 8);
+
+      if (crc == CRC16(&frame[2], 1 + len))
+      {
+        printFrame(&frame[3], len);
+      }
+      else
+      {
+        number_of_bad_frames++;
+      }
+      cnt = 0;
+    }
+  }
+  std::fprintf(stderr, "frames with bad crc: %lu\n", number_of_bad_frames);
+  return 0;
+}
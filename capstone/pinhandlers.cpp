@@ -10,28 +10,310 @@
 
 #include "capstone.hpp"
 
-PinReader::PinReader(pinId_t const pinId)
+static PinReader *adc_readers[ADC_READERS_MAX] = { };
+static int8_t volatile number_of_adc_readers = 0;
+static int8_t number_of_lost_readers = 0;
+static int8_t volatile adc_cursor = 0;
+static bool volatile adc_sampler_running = false;
+static uint16_t volatile adc_scans = 0;
+static uint16_t volatile adc_rounds = 0;
+static bool adc_windows_held = false;
+static TripGuard *volatile adc_guard = nullptr;
+
+static constexpr
+uint8_t shiftOf(uint16_t const len)
+{
+  return len > 1 ? 1 + shiftOf(len >> 1) : 0;
+}
+
+static_assert((1 << shiftOf(ADC_WINDOW_MIN)) == ADC_WINDOW_MIN && (1 << shiftOf(ADC_WINDOW_MAX)) == ADC_WINDOW_MAX && (1 << shiftOf(ADC_WINDOW_LEN)) == ADC_WINDOW_LEN, "The lengths of windows must be powers of 2.");
+static_assert(ADC_WINDOW_MIN <= ADC_WINDOW_LEN && ADC_WINDOW_LEN <= ADC_WINDOW_MAX && ADC_WINDOW_MAX <= 128, "`PinReader::adaptWindow` assumes windows of at most 128 samples.");
+static_assert(ADC_FRACTION_BITS <= 4, "`PinReader::target_variance` assumes at most 4 fractional bits.");
+
+static inline
+uint8_t adcChannelOf(pinId_t const pinId)
+{
+  return pinId >= Apin(0) ? pinId - Apin(0) : pinId;
+}
+
+#if defined(ADC_vect)
+ISR(ADC_vect)
+{
+  int const signal = ADC;
+  PinReader *const sampled = adc_readers[adc_cursor];
+  uint16_t const round = adc_rounds;
+
+  if (++adc_cursor >= number_of_adc_readers)
+  {
+    adc_cursor = 0;
+    adc_rounds = round + 1;
+  }
+  ADMUX = (1 << REFS0) | (adcChannelOf(adc_readers[adc_cursor]->pin_to_handle) & 0x07);
+  ADCSRA |= (1 << ADSC);
+  if (sampled->takeSample(signal, round))
+  {
+    adc_scans++;
+  }
+  if (adc_guard)
+  {
+    adc_guard->check(sampled);
+  }
+}
+#endif
+
+void beginAdcSampler()
+{
+  if (number_of_lost_readers > 0)
+  {
+    serr << F("ADC readers over `ADC_READERS_MAX` are not sampled: lost = ") << static_cast<int>(number_of_lost_readers) << F(".");
+  }
+#if defined(ADC_vect)
+  if (number_of_adc_readers > 0 && not adc_sampler_running)
+  {
+    for (int i = 0; i < number_of_adc_readers; i++)
+    {
+      adc_readers[i]->last_signal = analogRead(adc_readers[i]->pin_to_handle);
+      adc_readers[i]->sum_of_window = 0;
+      adc_readers[i]->cnt_of_window = 0;
+      adc_readers[i]->sum_of_last_window = 0;
+      adc_readers[i]->cnt_of_last_window = 0;
+      adc_readers[i]->sum_of_sq_diffs = 0;
+    }
+    adc_rounds = 0;
+    adc_cursor = 0;
+    adc_sampler_running = true;
+    ADMUX = (1 << REFS0) | (adcChannelOf(adc_readers[0]->pin_to_handle) & 0x07);
+    ADCSRA = (1 << ADEN) | (1 << ADIE) | (1 << ADSC) | (1 << ADPS2) | (1 << ADPS1) | (1 << ADPS0);
+    sout << F("ADC sampler started: channels = ") << static_cast<int>(number_of_adc_readers) << F(".");
+  }
+#endif
+}
+
+void endAdcSampler()
+{
+  if (adc_sampler_running)
+  {
+#if defined(ADC_vect)
+    ADCSRA &= ~(1 << ADIE);
+    while (ADCSRA & (1 << ADSC))
+    {
+    }
+#endif
+    adc_sampler_running = false;
+    sout << F("ADC sampler stopped.");
+  }
+}
+
+bool isAdcSamplerRunning()
+{
+  return adc_sampler_running;
+}
+
+uint16_t countAdcScans()
+{
+  uint16_t scans = 0;
+
+  noInterrupts();
+  scans = adc_scans;
+  interrupts();
+  return scans;
+}
+
+void holdAdcWindows()
+{
+  noInterrupts();
+  for (int i = 0; i < number_of_adc_readers; i++)
+  {
+    adc_readers[i]->sum_of_held_window = adc_readers[i]->sum_of_last_window;
+    adc_readers[i]->cnt_of_held_window = adc_readers[i]->cnt_of_last_window;
+  }
+  interrupts();
+  adc_windows_held = true;
+}
+
+void releaseAdcWindows()
+{
+  adc_windows_held = false;
+}
+
+PinReader::PinReader(pinId_t const pinId, Sig_t const target_error)
   : PinHandler{ .pin_to_handle = pinId }
+  , last_signal{ 0 }
+  , sum_of_window{ 0 }
+  , cnt_of_window{ 0 }
+  , sum_of_last_window{ 0 }
+  , cnt_of_last_window{ 0 }
+  , sum_of_held_window{ 0 }
+  , cnt_of_held_window{ 0 }
+  , sum_of_sq_diffs{ 0 }
+  , variance{ 0 }
+  , window_shift{ shiftOf(ADC_WINDOW_LEN) }
+  , target_variance{ static_cast<uint16_t>((static_cast<uint32_t>(target_error) * target_error) << (8 - 2 * ADC_FRACTION_BITS)) }
 {
+  if (number_of_adc_readers < ADC_READERS_MAX)
+  {
+    adc_readers[number_of_adc_readers++] = this;
+  }
+  else
+  {
+    number_of_lost_readers++;
+  }
 }
 PinReader::~PinReader()
 {
+  noInterrupts();
+  for (int i = 0; i < number_of_adc_readers; i++)
+  {
+    if (adc_readers[i] == this)
+    {
+      for (int j = i + 1; j < number_of_adc_readers; j++)
+      {
+        adc_readers[j - 1] = adc_readers[j];
+      }
+      adc_readers[--number_of_adc_readers] = nullptr;
+      if (adc_cursor > i)
+      {
+        adc_cursor--;
+      }
+      if (adc_cursor >= number_of_adc_readers)
+      {
+        adc_cursor = 0;
+      }
+      if (number_of_adc_readers == 0 && adc_sampler_running)
+      {
+#if defined(ADC_vect)
+        ADCSRA &= ~(1 << ADIE);
+#endif
+        adc_sampler_running = false;
+      }
+      break;
+    }
+  }
+  interrupts();
 }
 int PinReader::readSignalOnce() const
 {
+  if (isAdcSamplerRunning())
+  {
+    return last_signal;
+  }
   return analogRead(pin_to_handle);
 }
 Val_t PinReader::readSignal(ms_t const duration) const
 {
-  BigInt_t sum_of_vals = 0;
-  BigInt_t cnt_of_vals = 0;
+  uint32_t sum_of_vals = 0;
+  uint16_t const cnt_of_vals = this->collectSignal(duration, sum_of_vals);
 
-  for (Timer hourglass = { }; hourglass.getDuration() < duration; cnt_of_vals++)
+  if (cnt_of_vals == 0)
   {
-    sum_of_vals += this->readSignalOnce();
+    return last_signal;
   }
   return (static_cast<Val_t>(sum_of_vals)) / (static_cast<Val_t>(cnt_of_vals));
 }
+Sig_t PinReader::readSignalFixed(ms_t const duration) const
+{
+  uint32_t sum_of_vals = 0;
+  uint16_t const cnt_of_vals = this->collectSignal(duration, sum_of_vals);
+
+  if (cnt_of_vals == 0)
+  {
+    return last_signal << ADC_FRACTION_BITS;
+  }
+  return ((sum_of_vals << ADC_FRACTION_BITS) + (cnt_of_vals / 2)) / cnt_of_vals;
+}
+uint16_t PinReader::getWindowLength() const
+{
+  return 1u << window_shift;
+}
+uint16_t PinReader::getVariance() const
+{
+  uint16_t var = 0;
+
+  noInterrupts();
+  var = variance;
+  interrupts();
+  return var;
+}
+bool PinReader::takeSample(int const signal, uint16_t const round)
+{
+  int32_t const diff = signal - last_signal;
+
+  last_signal = signal;
+  sum_of_window += signal;
+  sum_of_sq_diffs += diff * diff;
+  cnt_of_window++;
+  if (((round + 1) & ((1u << window_shift) - 1)) == 0)
+  {
+    sum_of_last_window = sum_of_window;
+    cnt_of_last_window = cnt_of_window;
+    this->adaptWindow();
+    sum_of_window = 0;
+    cnt_of_window = 0;
+    sum_of_sq_diffs = 0;
+    return true;
+  }
+  return false;
+}
+void PinReader::adaptWindow()
+{
+  uint8_t shift = shiftOf(ADC_WINDOW_MIN);
+
+  if (cnt_of_window == (1u << window_shift))
+  {
+    uint32_t const var_of_window = sum_of_sq_diffs << (7 - window_shift);
+    int32_t const var = var_of_window < 0xFFFF ? var_of_window : 0xFFFF;
+
+    variance = variance == 0 ? var : variance + (var - variance) / 4;
+  }
+  while (shift < shiftOf(ADC_WINDOW_MAX) && variance > (static_cast<uint32_t>(target_variance) << shift))
+  {
+    shift++;
+  }
+  window_shift = shift;
+}
+bool PinReader::takeWindow(uint32_t &sum, uint16_t &cnt) const
+{
+  if (adc_windows_held && cnt_of_held_window > 0)
+  {
+    sum = sum_of_held_window;
+    cnt = cnt_of_held_window;
+    return true;
+  }
+  noInterrupts();
+  if (cnt_of_last_window > 0)
+  {
+    sum = sum_of_last_window;
+    cnt = cnt_of_last_window;
+  }
+  else
+  {
+    sum = sum_of_window;
+    cnt = cnt_of_window;
+  }
+  interrupts();
+  return cnt > 0;
+}
+uint16_t PinReader::collectSignal(ms_t const duration, uint32_t &sum) const
+{
+  us_t const window = static_cast<us_t>(duration) * 1000;
+  uint16_t cnt = 0;
+
+  sum = 0;
+  if (isAdcSamplerRunning())
+  {
+    for (Timer hourglass = { }; not this->takeWindow(sum, cnt) && hourglass.getMicros() < window; )
+    {
+    }
+  }
+  else
+  {
+    for (Timer hourglass = { }; hourglass.getMicros() < window; cnt++)
+    {
+      sum += this->readSignalOnce();
+    }
+  }
+  return cnt;
+}
 
 PinSetter::PinSetter(pinId_t const pinId)
   : PinHandler{ .pin_to_handle = pinId }
@@ -52,27 +334,191 @@ void PinSetter::syncPin()
 void PinSetter::initWith(bool const be_high)
 {
   is_high = be_high;
-  sout << "The pin " << pin_to_handle << " is initalized to " << (is_high ? "HIGH." : "LOW.");
+  sout << F("The pin ") << pin_to_handle << F(" is initalized to ") << (is_high ? F("HIGH.") : F("LOW."));
   this->openPin();
   this->syncPin();
 }
 void PinSetter::turnOn()
 {
-  is_high = true;
-  sout << "The pin " << pin_to_handle << " set to be " << "HIGH.";
-  this->syncPin();
+  if (not is_high)
+  {
+    is_high = true;
+    sout << F("The pin ") << pin_to_handle << F(" set to be ") << F("HIGH.");
+    this->syncPin();
+  }
 }
 void PinSetter::turnOff()
 {
-  is_high = false;
-  sout << "The pin " << pin_to_handle << " set to be " << "LOW.";  
-  this->syncPin();
+  if (is_high)
+  {
+    is_high = false;
+    sout << F("The pin ") << pin_to_handle << F(" set to be ") << F("LOW.");  
+    this->syncPin();
+  }
 }
 bool PinSetter::isHigh() const
 {
   return is_high;
 }
 
+PinGroup::~PinGroup()
+{
+}
+void PinGroup::set(int const pin_no, bool const be_high)
+{
+  if (pin_no >= 0 && pin_no < number_of_pins)
+  {
+    uint16_t const bit = 1u << pin_no;
+
+    staged_bits |= bit;
+    wanted_bits = be_high ? (wanted_bits | bit) : (wanted_bits & ~bit);
+  }
+}
+void PinGroup::commit()
+{
+#if defined(__AVR__)
+  struct {
+    uint8_t volatile *port;
+    uint8_t to_set;
+    uint8_t to_clear;
+  } writes[PIN_GROUP_MAX];
+  int number_of_writes = 0;
+#endif
+
+  for (int i = 0; i < number_of_pins; i++)
+  {
+    bool const be_high = wanted_bits & (1u << i);
+
+    if ((staged_bits & (1u << i)) && pins[i].is_high != be_high)
+    {
+      pins[i].is_high = be_high;
+      sout << F("The pin ") << pins[i].pin_to_handle << F(" set to be ") << (be_high ? F("HIGH.") : F("LOW."));
+#if defined(__AVR__)
+      uint8_t volatile *const port = portOutputRegister(digitalPinToPort(pins[i].pin_to_handle));
+      uint8_t const mask = digitalPinToBitMask(pins[i].pin_to_handle);
+      int w = 0;
+
+      while (w < number_of_writes && writes[w].port != port)
+      {
+        w++;
+      }
+      if (w == number_of_writes)
+      {
+        writes[w].port = port;
+        writes[w].to_set = 0;
+        writes[w].to_clear = 0;
+        number_of_writes++;
+      }
+      if (be_high)
+      {
+        writes[w].to_set |= mask;
+      }
+      else
+      {
+        writes[w].to_clear |= mask;
+      }
+#else
+      pins[i].syncPin();
+#endif
+    }
+  }
+  staged_bits = 0;
+#if defined(__AVR__)
+  if (number_of_writes > 0)
+  {
+    noInterrupts();
+    for (int w = 0; w < number_of_writes; w++)
+    {
+      *writes[w].port = (*writes[w].port & ~writes[w].to_clear) | writes[w].to_set;
+    }
+    interrupts();
+  }
+#endif
+}
+
+TripGuard::~TripGuard()
+{
+}
+void TripGuard::watch(int const limit_no, PinReader const *const plus, PinReader const *const minus)
+{
+  if (limit_no >= 0 && limit_no < number_of_limits)
+  {
+    noInterrupts();
+    limits[limit_no].plus = plus;
+    limits[limit_no].minus = minus;
+    limits[limit_no].lo = -no_limit;
+    limits[limit_no].hi = no_limit;
+    limits[limit_no].strikes = 0;
+    interrupts();
+  }
+}
+void TripGuard::setLimits(int const limit_no, int const lo, int const hi)
+{
+  if (limit_no >= 0 && limit_no < number_of_limits)
+  {
+    noInterrupts();
+    limits[limit_no].lo = lo;
+    limits[limit_no].hi = hi;
+    interrupts();
+  }
+}
+void TripGuard::arm()
+{
+  adc_guard = this;
+}
+void TripGuard::disarm()
+{
+  if (adc_guard == this)
+  {
+    adc_guard = nullptr;
+  }
+}
+void TripGuard::check(PinReader const *const sampled)
+{
+  if (fault_code != 0)
+  {
+    return;
+  }
+  for (int i = 0; i < number_of_limits; i++)
+  {
+    TripLimit &limit = limits[i];
+
+    if (limit.plus == sampled)
+    {
+      int const signal = limit.plus->last_signal - (limit.minus ? limit.minus->last_signal : 0);
+      bool const over = signal > limit.hi;
+
+      if (not over && signal >= limit.lo)
+      {
+        limit.strikes = 0;
+      }
+      else if (++limit.strikes >= TRIP_STRIKES)
+      {
+        this->trip(over ? 0x10 | i : 0x20 | i);
+        return;
+      }
+    }
+  }
+}
+uint8_t TripGuard::getFault() const
+{
+  return fault_code;
+}
+void TripGuard::clear()
+{
+  fault_code = 0;
+}
+void TripGuard::trip(uint8_t const code)
+{
+  fault_code = code;
+  breaker->is_high = false;
+#if defined(__AVR__)
+  *portOutputRegister(digitalPinToPort(breaker->pin_to_handle)) &= ~digitalPinToBitMask(breaker->pin_to_handle);
+#else
+  digitalWrite(breaker->pin_to_handle, LOW);
+#endif
+}
+
 PwmSetter::PwmSetter(pinId_t const pinId)
   : PinHandler{ .pin_to_handle = pinId }
 {
@@ -86,7 +532,7 @@ void PwmSetter::openPin() const
 }
 void PwmSetter::init() const
 {
-  sout << "The pin " << pin_to_handle << " is initalized to " << "LOW.";
+  sout << F("The pin ") << pin_to_handle << F(" is initalized to ") << F("LOW.");
   this->openPin();
   analogWrite(pin_to_handle, LOW);
 }
@@ -94,18 +540,18 @@ void PwmSetter::set(double const duty_ratio) const
 {
   if (duty_ratio < 0.0)
   {
-    sout << "The pin " << pin_to_handle << " set to be " << "LOW.";  
+    sout << F("The pin ") << pin_to_handle << F(" set to be ") << F("LOW.");  
     analogWrite(pin_to_handle, LOW);
   }
   else if (duty_ratio >= 1.0)
   {
-    sout << "The pin " << pin_to_handle << " set to be " << "HIGH.";  
+    sout << F("The pin ") << pin_to_handle << F(" set to be ") << F("HIGH.");  
     analogWrite(pin_to_handle, HIGH);
   }
   else
   {
     int const PWM_value = 256 * duty_ratio;
-    sout << "The pin " << pin_to_handle << " set to be " << PWM_value << ".";  
+    sout << F("The pin ") << pin_to_handle << F(" set to be ") << PWM_value << F(".");  
     analogWrite(pin_to_handle, PWM_value);
   }
 }
@@ -10,6 +10,48 @@
 
 #include "capstone.hpp"
 
+struct LcdShadow {
+  LcdHandle_t handle;
+  char glass[LCD_HEIGHT][LCD_WIDTH];
+};
+
+static LcdShadow lcdShadows[LCD_SHADOWS_MAX] = { };
+static int8_t lcdShadowToEvict = 0;
+
+static
+LcdShadow *lcdShadowOf(LcdHandle_t const lcdHandle)
+{
+  for (int i = 0; i < LCD_SHADOWS_MAX; i++)
+  {
+    if (lcdShadows[i].handle == lcdHandle)
+    {
+      return &lcdShadows[i];
+    }
+  }
+  return nullptr;
+}
+
+static
+LcdShadow *resetLcdShadow(LcdHandle_t const lcdHandle)
+{
+  LcdShadow *shadow = lcdShadowOf(lcdHandle);
+
+  if (not shadow)
+  {
+    shadow = &lcdShadows[lcdShadowToEvict];
+    lcdShadowToEvict = (lcdShadowToEvict + 1) % LCD_SHADOWS_MAX;
+  }
+  shadow->handle = lcdHandle;
+  for (int c = 0; c < LCD_HEIGHT; c++)
+  {
+    for (int r = 0; r < LCD_WIDTH; r++)
+    {
+      shadow->glass[c][r] = ' ';
+    }
+  }
+  return shadow;
+}
+
 LcdHandle_t openLcdI2C(int const lcdWidth, int const lcdHeight)
 {
   LcdHandle_t myLcdHandle = nullptr;
@@ -26,11 +68,11 @@ LcdHandle_t openLcdI2C(int const lcdWidth, int const lcdHeight)
       response = Wire.endTransmission(adr);
       if (response == 0)
       {
-        sout << "I2C address found: address = " << adr << ".";
+        sout << F("I2C address found: address = ") << adr << F(".");
         myLcdHandle = new LiquidCrystal_I2C(adr, lcdWidth, lcdHeight);
         if (myLcdHandle)
         {
-          sout << "I2C connected: address = " << adr << ".";
+          sout << F("I2C connected: address = ") << adr << F(".");
           break;
         }
       }
@@ -41,6 +83,7 @@ LcdHandle_t openLcdI2C(int const lcdWidth, int const lcdHeight)
     {
       myLcdHandle->init();
       myLcdHandle->backlight();
+      resetLcdShadow(myLcdHandle);
     }
   }
   return myLcdHandle;
@@ -52,9 +95,9 @@ LcdPrinter::LcdPrinter(LcdHandle_t const &lcdHandleRef)
   , auxiliary_buffer{ }
   , main_buffer{ }
 {
-  for (int c = 0; c < LENGTH(main_buffer); c++)
+  for (int c = 0; c < static_cast<int>(LENGTH(main_buffer)); c++)
   {
-    for (int r = 0; r < LENGTH(*main_buffer); r++)
+    for (int r = 0; r < static_cast<int>(LENGTH(*main_buffer)); r++)
     {
       main_buffer[c][r] = '\0';
     }
@@ -74,6 +117,7 @@ void LcdPrinter::overwrite()
 void LcdPrinter::clear()
 {
   lcdHandle->clear();
+  resetLcdShadow(lcdHandle);
   section_no = 0;
   for (int c = 0; c < LCD_HEIGHT; c++)
   {
@@ -89,12 +133,35 @@ void LcdPrinter::send()
 {
   if (lcdHandle)
   {
-    lcdHandle->clear();
+    LcdShadow *shadow = lcdShadowOf(lcdHandle);
+
+    if (not shadow)
+    {
+      lcdHandle->clear();
+      shadow = resetLcdShadow(lcdHandle);
+    }
     for (int c = 0; c < LCD_HEIGHT; c++)
     {
-      lcdHandle->setCursor(0, c);
+      bool end_of_line = false;
       main_buffer[c][LCD_WIDTH] = '\0';
-      lcdHandle->print(main_buffer[c]);
+      for (int r = 0; r < LCD_WIDTH; r++)
+      {
+        end_of_line |= main_buffer[c][r] == '\0';
+        main_buffer[c][r] = end_of_line ? ' ' : main_buffer[c][r];
+      }
+      for (int r = 0; r < LCD_WIDTH; r++)
+      {
+        if (main_buffer[c][r] != shadow->glass[c][r])
+        {
+          lcdHandle->setCursor(r, c);
+          while (r < LCD_WIDTH && (main_buffer[c][r] != shadow->glass[c][r] || (r + 1 < LCD_WIDTH && main_buffer[c][r + 1] != shadow->glass[c][r + 1])))
+          {
+            lcdHandle->write(main_buffer[c][r]);
+            shadow->glass[c][r] = main_buffer[c][r];
+            r++;
+          }
+        }
+      }
     }
   }
 }
@@ -143,110 +210,374 @@ void LcdPrinter::println(char const *const str)
   this->print(str);
   this->newline();
 }
+void LcdPrinter::print(__FlashStringHelper const *const str)
+{
+  auxiliary_buffer.putString(str);
+}
+void LcdPrinter::println(__FlashStringHelper const *const str)
+{
+  this->print(str);
+  this->newline();
+}
 
-SerialPrinter::SerialPrinter(SerialPrinter &&other)
-  : prefix_of_message{ other.prefix_of_message }
-  , newline{ other.newline }
+static struct {
+  char buf[SERIAL_RING_LEN];
+  int lens[SERIAL_MESSAGES_MAX];
+  int head;
+  int size;
+  int first;
+  int count;
+  int pending;
+  bool started;
+  bool dropping;
+  unsigned long drops;
+} serialRing = { .buf = { }, .lens = { }, .head = 0, .size = 0, .first = 0, .count = 0, .pending = 0, .started = false, .dropping = false, .drops = 0 };
+
+// The length of the `nth` oldest sealed message; of the one being sent, what remains of it.
+static
+int lengthOfSerial(int const nth)
 {
-  other.newline = false;
+  return serialRing.lens[(serialRing.first + nth) % SERIAL_MESSAGES_MAX];
 }
-SerialPrinter::SerialPrinter(char const *const prefix)
-  : prefix_of_message{ prefix }
-  , newline{ false }
+
+#if SERIAL_OVERFLOW == SERIAL_DROP_OLDEST
+// Discards the oldest sealed message which the port has not begun to send.
+static
+bool dropOldestSerial()
 {
+  int const victim = serialRing.started ? 1 : 0;
+
+  if (serialRing.count <= victim)
+  {
+    return false;
+  }
+
+  int const len_of_victim = lengthOfSerial(victim);
+
+  if (serialRing.started)
+  {
+    int const len_of_head = lengthOfSerial(0);
+
+    // The rest of the message being sent slides over the next one.
+    for (int i = len_of_head - 1; i >= 0; i--)
+    {
+      serialRing.buf[(serialRing.head + len_of_victim + i) % SERIAL_RING_LEN] = serialRing.buf[(serialRing.head + i) % SERIAL_RING_LEN];
+    }
+    serialRing.lens[(serialRing.first + 1) % SERIAL_MESSAGES_MAX] = len_of_head;
+  }
+  serialRing.head = (serialRing.head + len_of_victim) % SERIAL_RING_LEN;
+  serialRing.size -= len_of_victim;
+  serialRing.first = (serialRing.first + 1) % SERIAL_MESSAGES_MAX;
+  serialRing.count--;
+  serialRing.drops++;
+  return true;
 }
-SerialPrinter::SerialPrinter(char const *const prefix, bool const lend)
-  : prefix_of_message{ prefix }
-  , newline{ lend }
+#endif
+
+// Makes room for `len` more characters of the message being queued, or discards the message.
+// A message which could not fit even if every other message were evicted is discarded before any of them is.
+static
+bool reserveSerial(int const len)
 {
+  if (serialRing.dropping)
+  {
+    return false;
+  }
+
+  bool const opening = serialRing.pending == 0 && len > 0;
+  int const room_max = SERIAL_RING_LEN - (serialRing.started ? lengthOfSerial(0) : 0);
+
+  if (serialRing.pending + len <= room_max)
+  {
+#if SERIAL_OVERFLOW == SERIAL_DROP_OLDEST
+    while ((serialRing.size + len > SERIAL_RING_LEN || (opening && serialRing.count >= SERIAL_MESSAGES_MAX)) && dropOldestSerial())
+    {
+    }
+#endif
+    if (serialRing.size + len <= SERIAL_RING_LEN && not (opening && serialRing.count >= SERIAL_MESSAGES_MAX))
+    {
+      return true;
+    }
+  }
+  serialRing.size -= serialRing.pending;
+  serialRing.pending = 0;
+  serialRing.dropping = true;
+  serialRing.drops++;
+  return false;
 }
-SerialPrinter::~SerialPrinter()
+
+static
+void pushSerial(char const ch)
+{
+  serialRing.buf[(serialRing.head + serialRing.size) % SERIAL_RING_LEN] = ch;
+  serialRing.size++;
+  serialRing.pending++;
+}
+
+static
+void queueSerial(char const ch)
+{
+  if (reserveSerial(1))
+  {
+    pushSerial(ch);
+  }
+}
+
+void sealSerial()
 {
 #if defined(SERIAL_PORT)
-  if (Serial)
+  if (serialRing.pending > 0)
+  {
+    serialRing.lens[(serialRing.first + serialRing.count) % SERIAL_MESSAGES_MAX] = serialRing.pending;
+    serialRing.count++;
+  }
+  serialRing.pending = 0;
+  serialRing.dropping = false;
+#endif
+}
+
+void queueSerial(char const *const str)
+{
+#if defined(SERIAL_PORT)
+  for (char const *p_ch = str; p_ch && *p_ch != '\0'; )
   {
-    if (newline)
+    int len = 0;
+
+    while (p_ch[len] != '\0' && p_ch[len++] != '\n')
+    {
+    }
+    if (reserveSerial(len))
     {
-      Serial.println("");
-      delay(5);
+      for (int i = 0; i < len; i++)
+      {
+        pushSerial(p_ch[i]);
+      }
+    }
+    if (p_ch[len - 1] == '\n')
+    {
+      sealSerial();
     }
+    p_ch += len;
   }
 #endif
 }
-void SerialPrinter::trick()
+
+void queueSerial(__FlashStringHelper const *const str)
 {
-  newline = false;
 #if defined(SERIAL_PORT)
-  if (Serial)
+  for (char const *p_ch = reinterpret_cast<char const *>(str); p_ch && pgm_read_byte(p_ch) != '\0'; )
   {
-    if (prefix_of_message)
+    int len = 0;
+
+    while (pgm_read_byte(p_ch + len) != '\0' && pgm_read_byte(p_ch + len++) != '\n')
     {
-      Serial.print(prefix_of_message);
     }
+    if (reserveSerial(len))
+    {
+      for (int i = 0; i < len; i++)
+      {
+        pushSerial(static_cast<char>(pgm_read_byte(p_ch + i)));
+      }
+    }
+    if (pgm_read_byte(p_ch + len - 1) == '\n')
+    {
+      sealSerial();
+    }
+    p_ch += len;
   }
 #endif
 }
-SerialPrinter SerialPrinter::operator<<(bool const is)
+
+void queueSerial(byte const *const bytes, int const len)
 {
-  this->trick();
 #if defined(SERIAL_PORT)
-  if (Serial)
+  if (reserveSerial(len))
   {
-    Serial.print(is ? "true" : "false");
+    for (int i = 0; i < len; i++)
+    {
+      pushSerial(static_cast<char>(bytes[i]));
+    }
   }
 #endif
-  return { .prefix = nullptr, .lend = true };
 }
-SerialPrinter SerialPrinter::operator<<(byte const hex)
+
+void pumpSerial()
 {
-  this->trick();
 #if defined(SERIAL_PORT)
   if (Serial)
   {
-    Serial.print("0x");
-    if (hex < 16)
+    for (int room = Serial.availableForWrite(); room > 0 && serialRing.count > 0; room--)
     {
-      Serial.print("0");
+      int &len_of_head = serialRing.lens[serialRing.first];
+
+      Serial.write(serialRing.buf[serialRing.head]);
+      serialRing.head = (serialRing.head + 1) % SERIAL_RING_LEN;
+      serialRing.size--;
+      len_of_head--;
+      serialRing.started = len_of_head > 0;
+      if (not serialRing.started)
+      {
+        serialRing.first = (serialRing.first + 1) % SERIAL_MESSAGES_MAX;
+        serialRing.count--;
+      }
     }
-    Serial.print(hex, HEX);
   }
 #endif
+}
+
+unsigned long droppedSerial()
+{
+  return serialRing.drops;
+}
+
+SerialPrinter::SerialPrinter(SerialPrinter &&other)
+  : prefix_of_message{ other.prefix_of_message }
+  , newline{ other.newline }
+{
+  other.newline = false;
+}
+SerialPrinter::SerialPrinter(__FlashStringHelper const *const prefix)
+  : prefix_of_message{ prefix }
+  , newline{ false }
+{
+}
+SerialPrinter::SerialPrinter(__FlashStringHelper const *const prefix, bool const lend)
+  : prefix_of_message{ prefix }
+  , newline{ lend }
+{
+}
+SerialPrinter::~SerialPrinter()
+{
+  if (newline)
+  {
+    queueSerial('\r');
+    queueSerial('\n');
+    sealSerial();
+    pumpSerial();
+  }
+}
+void SerialPrinter::trick()
+{
+  newline = false;
+  queueSerial(prefix_of_message);
+}
+SerialPrinter SerialPrinter::operator<<(bool const is)
+{
+  this->trick();
+  queueSerial(is ? F("true") : F("false"));
   return { .prefix = nullptr, .lend = true };
 }
-SerialPrinter SerialPrinter::operator<<(int const num)
+SerialPrinter SerialPrinter::operator<<(byte const hex)
 {
+  SizedFormatter<5> formatter = { };
+  char str[5 + 1] = { };
   this->trick();
-#if defined(SERIAL_PORT)
-  if (Serial)
+  formatter.putChar('0');
+  formatter.putChar('x');
+  if (hex < 16)
   {
-    Serial.print(num);
+    formatter.putChar('0');
   }
-#endif
+  formatter.putInt(hex, 16);
+  formatter.send(str);
+  str[formatter.size()] = '\0';
+  queueSerial(str);
+  return { .prefix = nullptr, .lend = true };
+}
+SerialPrinter SerialPrinter::operator<<(int const num)
+{
+  SizedFormatter<7> formatter = { };
+  char str[7 + 1] = { };
+  this->trick();
+  formatter.putInt(num, 10);
+  formatter.send(str);
+  str[formatter.size()] = '\0';
+  queueSerial(str);
   return { .prefix = nullptr, .lend = true };
 }
 SerialPrinter SerialPrinter::operator<<(char const *const str)
 {
   this->trick();
-#if defined(SERIAL_PORT)
-  if (Serial)
-  {
-    Serial.print(str);
-  }
-#endif
+  queueSerial(str);
+  return { .prefix = nullptr, .lend = true };
+}
+SerialPrinter SerialPrinter::operator<<(__FlashStringHelper const *const str)
+{
+  this->trick();
+  queueSerial(str);
   return { .prefix = nullptr, .lend = true };
 }
 SerialPrinter SerialPrinter::operator<<(double const val)
 {
+  SizedFormatter<24> formatter = { };
+  char str[24 + 1] = { };
   this->trick();
-#if defined(SERIAL_PORT)
-  if (Serial)
+  if (val != val)
   {
-    Serial.print(val);
+    formatter.putString(F("nan"));
   }
-#endif
+  else if (val > 4294967040.0 || val < -4294967040.0)
+  {
+    formatter.putString(F("ovf"));
+  }
+  else
+  {
+    formatter.putDouble(val, 2);
+  }
+  formatter.send(str);
+  str[formatter.size()] = '\0';
+  queueSerial(str);
   return { .prefix = nullptr, .lend = true };
 }
 
-SerialPrinter sout = { .prefix = "arduino> " };
-SerialPrinter serr = { .prefix = "WARNING> " };
-SerialPrinter slog = { .prefix = "       > " };
+static char const sout_prefix[] PROGMEM = "arduino> ";
+static char const serr_prefix[] PROGMEM = "WARNING> ";
+static char const slog_prefix[] PROGMEM = "       > ";
+
+SerialPrinter sout = { .prefix = FLASH_STR(sout_prefix) };
+SerialPrinter serr = { .prefix = FLASH_STR(serr_prefix) };
+SerialPrinter slog = { .prefix = FLASH_STR(slog_prefix) };
+
+TelemetryFrame::TelemetryFrame(byte const type)
+  : payload{ }
+  , cnt{ 0 }
+{
+  this->putU8(type);
+}
+TelemetryFrame::~TelemetryFrame()
+{
+  byte const header[] = { 0xA5, 0x5A, static_cast<byte>(cnt) };
+  uint16_t const crc = CRC16(payload, cnt, CRC16(&header[2], 1));
+  byte const footer[] = { static_cast<byte>(crc & 0xFF), static_cast<byte>(crc >> 8) };
+  reserveSerial(LENGTH(header) + cnt + LENGTH(footer));
+  queueSerial(header, LENGTH(header));
+  queueSerial(payload, cnt);
+  queueSerial(footer, LENGTH(footer));
+  sealSerial();
+  pumpSerial();
+}
+void TelemetryFrame::putU8(uint8_t const val)
+{
+  if (cnt < TELEMETRY_LEN_MAX)
+  {
+    payload[cnt++] = val;
+  }
+}
+void TelemetryFrame::putI16(int16_t const val)
+{
+  this->putU16(static_cast<uint16_t>(val));
+}
+void TelemetryFrame::putU16(uint16_t const val)
+{
+  this->putU8(val & 0xFF);
+  this->putU8(val >> 8);
+}
+void TelemetryFrame::putI32(int32_t const val)
+{
+  this->putU32(static_cast<uint32_t>(val));
+}
+void TelemetryFrame::putU32(uint32_t const val)
+{
+  this->putU16(val & 0xFFFF);
+  this->putU16(val >> 16);
+}
@@ -16,6 +16,20 @@ void delay1ms()
   delay(1);
 }
 
+static
+us_t microsOfBoard()
+{
+  return micros();
+}
+
+static us_t (*clock_source)() = microsOfBoard;
+
+static inline
+uint8_t *eepromAddressOf(int const address)
+{
+  return reinterpret_cast<uint8_t *>(static_cast<uintptr_t>(address));
+}
+
 void invokingSerial()
 {
 #if defined(SERIAL_PORT)
@@ -30,10 +44,8 @@ void invokingSerial()
 void drawlineSerial()
 {
 #if defined(SERIAL_PORT)
-  if (Serial)
-  {
-    Serial.println("=======");
-  }
+  queueSerial(F("=======\r\n"));
+  pumpSerial();
 #endif
 }
 
@@ -49,12 +61,33 @@ BigInt_t POW(BigInt_t base, int expn)
   return result;
 }
 
+uint16_t CRC16(byte const *const bytes, int const len, uint16_t crc)
+{
+  for (int i = 0; i < len; i++)
+  {
+    crc ^= static_cast<uint16_t>(bytes[i]) << 8;
+    for (int bit = 0; bit < 8; bit++)
+    {
+      crc = (crc & 0x8000) ? ((crc << 1) ^ 0x1021) : (crc << 1);
+    }
+  }
+  return crc;
+}
+
+us_t clockMicros()
+{
+  return clock_source();
+}
+void setClockSource(us_t (*const time_source)())
+{
+  clock_source = time_source;
+}
+
 Timer::Timer()
-  : begTime{ 0 }
+  : begTime{ clockMicros() }
 {
-  begTime = millis();
 }
-Timer::Timer(ms_t beg_time)
+Timer::Timer(us_t beg_time)
   : begTime{ beg_time }
 {
 }
@@ -63,24 +96,275 @@ Timer::~Timer()
 }
 void Timer::reset()
 {
-  begTime = millis();
+  begTime = clockMicros();
 }
 ms_t Timer::getDuration() const
 {
-  return millis() - begTime;
+  return this->getMicros() / 1000;
 }
 ms_t Timer::time() const
 {
-  return millis() - begTime;
+  return this->getMicros() / 1000;
+}
+us_t Timer::getMicros() const
+{
+  return clockMicros() - begTime;
 }
 void Timer::delay(ms_t const duration) const
 {
   while (this->time() < duration)
   {
+    pumpSerial();
     delay1ms();
   }
 }
 
+Task::Task(void (*const job)(), ms_t const period)
+  : job{ job }
+  , period{ period }
+  , next_due{ 0 }
+  , max_jitter{ 0 }
+  , max_duration{ 0 }
+  , overruns{ 0 }
+{
+}
+
+Scheduler::~Scheduler()
+{
+}
+void Scheduler::start()
+{
+  us_t const now = clockMicros();
+
+  for (int i = 0; i < number_of_tasks; i++)
+  {
+    tasks[i].next_due = now;
+    tasks[i].max_jitter = 0;
+    tasks[i].max_duration = 0;
+    tasks[i].overruns = 0;
+  }
+}
+void Scheduler::runOnce()
+{
+  for (int i = 0; i < number_of_tasks; i++)
+  {
+    Task &task = tasks[i];
+    us_t const now = clockMicros();
+
+    if (static_cast<int32_t>(now - task.next_due) >= 0)
+    {
+      us_t const period = static_cast<us_t>(task.period) * 1000;
+      us_t const jitter = now - task.next_due;
+      us_t duration = 0;
+
+      if (task.max_jitter < jitter)
+      {
+        task.max_jitter = jitter;
+      }
+      task.job();
+      duration = clockMicros() - now;
+      if (task.max_duration < duration)
+      {
+        task.max_duration = duration;
+      }
+      task.next_due += period;
+      if (static_cast<int32_t>(clockMicros() - task.next_due) >= 0)
+      {
+        task.overruns++;
+        task.next_due = clockMicros() + period;
+      }
+    }
+    pumpSerial();
+  }
+}
+us_t Scheduler::untilNextDue() const
+{
+  us_t const now = clockMicros();
+  us_t idle = 0xFFFFFFFFul;
+
+  for (int i = 0; i < number_of_tasks; i++)
+  {
+    int32_t const ahead = static_cast<int32_t>(tasks[i].next_due - now);
+
+    if (ahead <= 0)
+    {
+      return 0;
+    }
+    if (idle > static_cast<us_t>(ahead))
+    {
+      idle = ahead;
+    }
+  }
+  return idle;
+}
+bool Scheduler::report()
+{
+  int const i = task_to_report;
+
+  slog << F("task[") << i << F("]: period = ") << static_cast<int>(tasks[i].period) << F("[ms], max_jitter = ") << tasks[i].max_jitter / 1000.0 << F("[ms], max_duration = ") << tasks[i].max_duration / 1000.0 << F("[ms], overruns = ") << static_cast<int>(tasks[i].overruns) << F(".");
+  task_to_report = (i + 1) % number_of_tasks;
+  return task_to_report == 0;
+}
+
+StateMachine::~StateMachine()
+{
+}
+bool StateMachine::raise(uint8_t const event)
+{
+  for (int i = 0; i < number_of_transitions; i++)
+  {
+    Transition const transition = this->transition_at(i);
+
+    if (transition.from == state && transition.event == event)
+    {
+      state = transition.to;
+      if (transition.action)
+      {
+        transition.action();
+      }
+      return true;
+    }
+  }
+  return false;
+}
+void StateMachine::reset(uint8_t const init_state)
+{
+  state = init_state;
+}
+uint8_t StateMachine::getState() const
+{
+  return state;
+}
+Transition StateMachine::transition_at(int const i) const
+{
+  return transitions_in_flash ? readFlash(&transitions[i]) : transitions[i];
+}
+void StateMachine::dumpWith(char const *const state_names, int const state_name_len, char const *const event_names, int const event_name_len) const
+{
+  for (int i = 0; i < number_of_transitions; i++)
+  {
+    Transition const transition = this->transition_at(i);
+
+    slog << FLASH_STR(&state_names[transition.from * state_name_len]) << F(" --") << FLASH_STR(&event_names[transition.event * event_name_len]) << F("--> ") << FLASH_STR(&state_names[transition.to * state_name_len]) << F(".");
+    pumpSerial();
+  }
+}
+
+CoulombCounter::CoulombCounter()
+  : twice_charge{ 0 }
+  , last_current{ 0 }
+  , last_time{ 0 }
+  , has_last_sample{ false }
+{
+}
+CoulombCounter::~CoulombCounter()
+{
+}
+void CoulombCounter::reset(mAh_t const init_charge)
+{
+  twice_charge = 2 * ROUND(init_charge * 3600000000.0);
+  has_last_sample = false;
+}
+void CoulombCounter::integrate(us_t const time, mA_t const current, bool const counting)
+{
+  if (has_last_sample && counting)
+  {
+    // (mA + mA) * us = 2 * (mA + mA) / 2 * us = 2 * uAms
+    twice_charge += (static_cast<int32_t>(last_current) + current) * static_cast<uAms_t>(time - last_time);
+  }
+  last_current = current;
+  last_time = time;
+  has_last_sample = true;
+}
+uAms_t CoulombCounter::get_uAms() const
+{
+  return twice_charge / 2;
+}
+int32_t CoulombCounter::get_uAh() const
+{
+  return twice_charge / 7200000;
+}
+mAh_t CoulombCounter::get_mAh() const
+{
+  return twice_charge / 7200000000.0;
+}
+
+EepromRing::EepromRing(int const base, int const len_of_payload, int const size_of_ring)
+  : base_address{ base }
+  , size_of_payload{ len_of_payload }
+  , size_of_slot{ len_of_payload + 4 }
+  , number_of_slots{ len_of_payload + 4 <= EEPROM_RECORD_MAX ? size_of_ring / (len_of_payload + 4) : 0 }
+  , record{ }
+  , next_slot{ 0 }
+  , next_seq{ 0 }
+  , cursor{ -1 }
+{
+}
+EepromRing::~EepromRing()
+{
+}
+bool EepromRing::load(void *const payload)
+{
+  bool found = false;
+  uint16_t newest_seq = 0;
+  int newest_slot = -1;
+
+  for (int slot = 0; slot < number_of_slots; slot++)
+  {
+    eeprom_read_block(record, eepromAddressOf(base_address + slot * size_of_slot), size_of_slot);
+
+    uint16_t const seq = record[0] | (record[1] << 8);
+    uint16_t const crc = record[size_of_slot - 2] | (record[size_of_slot - 1] << 8);
+
+    if (CRC16(record, size_of_slot - 2) == crc && (not found || static_cast<int16_t>(seq - newest_seq) > 0))
+    {
+      found = true;
+      newest_seq = seq;
+      newest_slot = slot;
+      memcpy(payload, &record[2], size_of_payload);
+    }
+  }
+  next_slot = found ? (newest_slot + 1) % number_of_slots : 0;
+  next_seq = found ? newest_seq + 1 : 0;
+  cursor = -1;
+  return found;
+}
+bool EepromRing::save(void const *const payload)
+{
+  if (number_of_slots == 0 || this->isBusy())
+  {
+    return false;
+  }
+
+  uint16_t crc = 0;
+
+  record[0] = next_seq & 0xFF;
+  record[1] = next_seq >> 8;
+  memcpy(&record[2], payload, size_of_payload);
+  crc = CRC16(record, size_of_slot - 2);
+  record[size_of_slot - 2] = crc & 0xFF;
+  record[size_of_slot - 1] = crc >> 8;
+  next_seq++;
+  cursor = 0;
+  return true;
+}
+void EepromRing::pump()
+{
+  if (this->isBusy() && eeprom_is_ready())
+  {
+    eeprom_update_byte(eepromAddressOf(base_address + next_slot * size_of_slot + cursor), record[cursor]);
+    if (++cursor >= size_of_slot)
+    {
+      cursor = -1;
+      next_slot = (next_slot + 1) % number_of_slots;
+    }
+  }
+}
+bool EepromRing::isBusy() const
+{
+  return cursor >= 0;
+}
+
 AscList::~AscList()
 {
 }
@@ -93,7 +377,7 @@ bool AscList::isValid() const
     validity = left_bound_of_xs < right_bound_of_xs;
     for (int i = 0; i < number_of_intervals; i++)
     {
-      validity &= ys[i] < ys[i + 1];
+      validity &= this->y_at(i) < this->y_at(i + 1);
     }
   }
   return validity;
@@ -102,44 +386,62 @@ double AscList::get_y_by_x(double const x) const
 {
   if (x <= left_bound_of_xs)
   {
-    return ys[0];
+    return this->y_at(0);
   }
   else if (x >= right_bound_of_xs)
   {
-    return ys[number_of_intervals];
+    return this->y_at(number_of_intervals);
   }
   else
   {
     double const param = (x - left_bound_of_xs) * (number_of_intervals / (right_bound_of_xs - left_bound_of_xs));
     int const idx = param;
 
+    Val_t const y_idx = this->y_at(idx);
+
     if (static_cast<double>(idx) == param)
     {
-      return ys[idx];
+      return y_idx;
     }
     else
     {
-      return ((ys[idx + 1] - ys[idx]) * (param - idx)) + ys[idx];
+      return ((this->y_at(idx + 1) - y_idx) * (param - idx)) + y_idx;
     }
   }
 }
+double AscList::get_slope_by_x(double const x) const
+{
+  double const param = (x - left_bound_of_xs) * (number_of_intervals / (right_bound_of_xs - left_bound_of_xs));
+  int const idx = param <= 0.0 ? 0 : param >= number_of_intervals ? number_of_intervals - 1 : static_cast<int>(param);
+
+  return (this->y_at(idx + 1) - this->y_at(idx)) * (number_of_intervals / (right_bound_of_xs - left_bound_of_xs));
+}
 double AscList::get_x_by_parameter(double const param) const
 {
   return ((param * (right_bound_of_xs - left_bound_of_xs) / number_of_intervals) + left_bound_of_xs);
 }
 double AscList::get_x_by_y(double const y) const
 {
+  if (codes_of_ys)
+  {
+    return this->get_x_by_y_with_codes(y);
+  }
+  if (index_of_ys)
+  {
+    return this->get_x_by_y_with_index(y);
+  }
+
   int low = 0, high = number_of_intervals;
 
   while (low <= high)
   {
     int mid = low + ((high - low) / 2);
 
-    if (ys[mid] > y)
+    if (this->y_at(mid) > y)
     {
       high = mid - 1;
     }
-    else if (ys[mid] < y)
+    else if (this->y_at(mid) < y)
     {
       low = mid + 1;
     }
@@ -158,6 +460,200 @@ double AscList::get_x_by_y(double const y) const
   }
   else
   {
-    return this->get_x_by_parameter(((y - ys[high]) / (ys[low] - ys[high])) * (low - high) + high);
+    Val_t const y_high = this->y_at(high);
+
+    return this->get_x_by_parameter(((y - y_high) / (this->y_at(low) - y_high)) * (low - high) + high);
+  }
+}
+void AscList::buildIndex()
+{
+  int idx = 0;
+
+  for (int bucket = 0; bucket < number_of_buckets; bucket++)
+  {
+    if (codes_of_ys)
+    {
+      Val_t const code_low = this->code_at(0) + bucket / buckets_per_y;
+
+      while (idx < number_of_intervals - 1 && this->code_at(idx + 1) <= code_low)
+      {
+        idx++;
+      }
+    }
+    else
+    {
+      Val_t const y_low = this->y_at(0) + bucket / buckets_per_y;
+
+      while (idx < number_of_intervals - 1 && this->y_at(idx + 1) <= y_low)
+      {
+        idx++;
+      }
+    }
+    index_of_ys[bucket] = idx;
+  }
+}
+double AscList::get_x_by_y_with_index(double const y) const
+{
+  if (y <= this->y_at(0))
+  {
+    return this->get_x_by_parameter(0);
+  }
+  else if (y >= this->y_at(number_of_intervals))
+  {
+    return this->get_x_by_parameter(number_of_intervals);
+  }
+  else
+  {
+    int const bucket = (y - this->y_at(0)) * buckets_per_y;
+    int idx = index_of_ys[bucket < number_of_buckets ? bucket : number_of_buckets - 1];
+    Val_t y_next = this->y_at(idx + 1);
+
+    while (y_next < y)
+    {
+      idx++;
+      y_next = this->y_at(idx + 1);
+    }
+
+    Val_t const y_idx = this->y_at(idx);
+
+    return this->get_x_by_parameter(((y - y_idx) / (y_next - y_idx)) + idx);
   }
 }
+
+double AscList::get_x_by_y_with_codes(double const y) const
+{
+  Val_t const code = (y - base_of_ys) * codes_per_y;
+
+  if (code < 0.0)
+  {
+    return this->get_x_by_parameter(0);
+  }
+  else if (code >= 65535.0)
+  {
+    return this->get_x_by_parameter(number_of_intervals);
+  }
+
+  // `code_at(i) <= code` if and only if `code_at(i) <= key`, since `code_at(i)` is an integer.
+  uint16_t const key = code;
+  uint16_t const code_of_first = this->code_at(0);
+  int idx = 0;
+
+  if (key < code_of_first)
+  {
+    return this->get_x_by_parameter(0);
+  }
+  else if (key >= this->code_at(number_of_intervals))
+  {
+    return this->get_x_by_parameter(number_of_intervals);
+  }
+  else if (index_of_ys)
+  {
+    int const bucket = (key - code_of_first) * buckets_per_y;
+
+    idx = index_of_ys[bucket < number_of_buckets ? bucket : number_of_buckets - 1];
+    while (this->code_at(idx + 1) <= key)
+    {
+      idx++;
+    }
+  }
+  else
+  {
+    int high = number_of_intervals;
+
+    while (high - idx > 1)
+    {
+      int const mid = idx + ((high - idx) / 2);
+
+      if (this->code_at(mid) <= key)
+      {
+        idx = mid;
+      }
+      else
+      {
+        high = mid;
+      }
+    }
+  }
+
+  uint16_t const code_of_idx = this->code_at(idx);
+
+  return this->get_x_by_parameter(((code - code_of_idx) / (this->code_at(idx + 1) - code_of_idx)) + idx);
+}
+
+SocEstimator::SocEstimator()
+  : ocv_table{ nullptr }
+  , params{ nullptr }
+  , soc{ 0.0f }
+  , Vrc{ 0.0f }
+  , P{ { 0.0f, 0.0f }, { 0.0f, 0.0f } }
+  , last_charge{ 0 }
+  , last_time{ 0 }
+{
+}
+SocEstimator::~SocEstimator()
+{
+}
+void SocEstimator::init(AscList const *const ocv_table_ref, EcmParameters const *const params_ref)
+{
+  ocv_table = ocv_table_ref;
+  params = params_ref;
+}
+void SocEstimator::reset(float const init_soc, uAms_t const charge, us_t const time)
+{
+  soc = init_soc;
+  Vrc = 0.0f;
+  P[0][0] = 100.0f;
+  P[0][1] = 0.0f;
+  P[1][0] = 0.0f;
+  P[1][1] = 0.0001f;
+  last_charge = charge;
+  last_time = time;
+}
+void SocEstimator::update(uAms_t const charge, us_t const time, mA_t const current, mV_t const voltage, bool const measuring)
+{
+  float const I = current / 1000.0f;
+  float const dt = (time - last_time) / 1000.0f;
+  float const decay = dt < params->tau ? 1.0f - dt / params->tau : 0.0f;
+
+  // PREDICT
+  soc += (charge - last_charge) * (100.0f / 3600000000.0f) / params->capacity;
+  Vrc = decay * Vrc + (1.0f - decay) * params->R1 * I;
+  P[0][0] += params->var_of_soc * dt;
+  P[0][1] *= decay;
+  P[1][0] = P[0][1];
+  P[1][1] = decay * decay * P[1][1] + params->var_of_Vrc * dt;
+  last_charge = charge;
+  last_time = time;
+
+  // CORRECT
+  if (measuring)
+  {
+    float const H0 = ocv_table->get_slope_by_x(soc);
+    float const PH0 = P[0][0] * H0 + P[0][1];
+    float const PH1 = P[1][0] * H0 + P[1][1];
+    float const S = H0 * PH0 + PH1 + params->var_of_V;
+    float const K0 = PH0 / S;
+    float const K1 = PH1 / S;
+    float const err = voltage / 1000.0f - (static_cast<float>(ocv_table->get_y_by_x(soc)) + Vrc + params->R0 * I);
+
+    soc += K0 * err;
+    Vrc += K1 * err;
+    P[0][0] -= K0 * PH0;
+    P[0][1] -= K0 * PH1;
+    P[1][1] -= K1 * PH1;
+    P[1][0] = P[0][1];
+  }
+  soc = soc < 0.0f ? 0.0f : soc > 100.0f ? 100.0f : soc;
+}
+float SocEstimator::get_soc() const
+{
+  return soc;
+}
+float SocEstimator::get_Vrc() const
+{
+  return Vrc;
+}
+float SocEstimator::get_var_of_soc() const
+{
+  return P[0][0];
+}
@@ -21,6 +21,10 @@
 
 // Please do NOT manipulate any macros other than these:
 #define SERIAL_PORT       9600
+#define SERIAL_RING_LEN   256
+#define SERIAL_OVERFLOW   SERIAL_DROP_OLDEST
+#define TELEMETRY_MODE    TELEMETRY_TEXT
+#define SOC_ESTIMATOR     SOC_COULOMB
 #define OPERATING_MODE    3
 #define LCD_WIDTH         16
 #define LCD_HEIGHT        2
@@ -135,6 +139,250 @@
 ** 1. `VERSION` updated to `1.20`.
 ** [2022-05-21]
 ** 1. `VERSION` updated to `2.00`.
+** [2026-10-17]
+** 1. The interrupt-driven ADC sampler introduced.
+**    -- Functions added `beginAdcSampler`,
+**                       `endAdcSampler`,
+**                       `isAdcSamplerRunning`.
+**    -- Methods corrected `PinReader::readSignalOnce`,
+**                         `PinReader::readSignal`.
+** 2. The fixed-point measurement pipeline introduced.
+**    -- Types added `mV_t`,
+**                   `mA_t`,
+**                   `Sig_t`.
+**    -- Method added `PinReader::readSignalFixed`.
+**    -- Methods corrected `BMS::checkPowerConnected`,
+**                         `BMS::checkCellsAttatched`,
+**                         `BMS::measureValues`,
+**                         `BMS::loop`.
+**    -- Cell voltages and currents are kept in millivolts and milliamperes,
+**       and converted into `Vol_t` and `Amp_t` only when being displayed.
+** 3. The class `AscList` improved.
+**    -- Constructor added, which takes an index buffer of uniform buckets of `ys`.
+**    -- Method improved `AscList::get_x_by_y`.
+**    -- `mySocOcvTable` and `mySocVcellTable` are indexed by 64 buckets.
+** 4. The class `Map2d` improved.
+**    -- Field eliminated `Map2d::ys`.
+**    -- Type added `Map2d::Row`.
+**    -- Methods added `Map2d::get_row_by_s`,
+**                     `Map2d::get_y_by_row`.
+**    -- Methods corrected `Map2d::get_x_by_y`,
+**                         `Map2d::with_s_get_x_by_y`.
+** 5. The class `SizedFormatter` improved.
+**    -- Methods added `SizedFormatter::putDigits`,
+**                     `SizedFormatter::putUnsigned`.
+**    -- Methods improved `SizedFormatter::putInt`,
+**                        `SizedFormatter::putDouble`.
+**    -- The method `SizedFormatter::putDouble` splits the value in 32 bits when it fits.
+** 6. The method `LcdPrinter::send` improved.
+**    -- The screen is no longer cleared and redrawn as a whole;
+**       only the runs of characters differing from the shadow of the screen are sent.
+**    -- Macro added `LCD_SHADOWS_MAX`, the number of handles whose screens are shadowed.
+** 7. The class `SerialPrinter` improved.
+**    -- Functions added `queueSerial`,
+**                       `sealSerial`,
+**                       `pumpSerial`,
+**                       `droppedSerial`.
+**    -- Messages are queued into a ring buffer of `SERIAL_RING_LEN` characters,
+**       and `delay(5);` after each line removed.
+**    -- A message, i.e. a line or a telemetry frame, is sent or discarded as a whole.
+**    -- Macros added `SERIAL_RING_LEN`,
+**                    `SERIAL_OVERFLOW`,
+**                    `SERIAL_MESSAGES_MAX`.
+**    -- The lengths of the messages are kept in a ring of `SERIAL_MESSAGES_MAX`,
+**       and a message which can never fit is discarded before the older ones are evicted.
+** 8. The binary telemetry mode introduced.
+**    -- Class added `TelemetryFrame`.
+**    -- Function added `CRC16`.
+**    -- Macro added `TELEMETRY_MODE`.
+**    -- Files added `capstone/host/telemetry2csv.cpp`.
+**    -- The frames of the type `0x01` carry `BMS::Qs`, as `SOC_ESTIMATOR` gives it.
+** 9. The cooperative multi-rate scheduler introduced.
+**    -- Classes added `Task`,
+**                     `Scheduler`.
+**    -- The method `BMS::loop` split into `BMS::measure` (100Hz),
+**                                         `BMS::control` (10Hz),
+**                                         `BMS::display` (2Hz),
+**                                         `BMS::report` (1Hz) and
+**                                         `BMS::stats` (0.1Hz).
+**    -- `Scheduler::report` prints one task per call, taking the tasks in turn.
+**    -- The methods `PinSetter::turnOn` and `PinSetter::turnOff` do nothing if the state of the pin is unchanged.
+** 10. The host simulation introduced.
+**     -- Files added `capstone/host/Arduino.h`,
+**                    `capstone/host/Wire.h`,
+**                    `capstone/host/LiquidCrystal_I2C.h`,
+**                    `capstone/host/hal.hpp`,
+**                    `capstone/host/hal.cpp`,
+**                    `capstone/host/simulation.cpp`,
+**                    `capstone/host/build.sh`.
+**     -- `sh capstone/host/build.sh` builds `_host_build/simulation` and `_host_build/telemetry2csv`,
+**        with `-Wall -Wextra`.
+** 11. Host benchmarks added.
+**     -- "host/bench.cpp" measures the lookup tables, `POW` and the formatters,
+**        and gives a static estimate of AVR cycles from a cost model of the soft-float routines,
+**        written next to each benchmark.
+** 12. The class `CoulombCounter` introduced.
+**     -- Type added `uAms_t`.
+**     -- Fields eliminated `BMS::Qs_lastUpdatedTime`.
+**     -- Field added `BMS::Qs_counters`.
+**     -- Every sample of `Iin` taken by `BMS::measure` is integrated by the trapezoidal rule,
+**        skipping the cells whose `DISCHARGER_pin` is high at the sample.
+**     -- `BMS::Qs` is derived from `BMS::Qs_counters` in `BMS::control`.
+** 13. The extended Kalman filter of SOC introduced.
+**     -- Classes added `EcmParameters`,
+**                      `SocEstimator`.
+**     -- Method added `AscList::get_slope_by_x`.
+**     -- Macros added `SOC_ESTIMATOR`,
+**                     `SOC_COULOMB`,
+**                     `SOC_EKF`.
+**     -- Fields added `BMS::cellVs_measured`,
+**                     `BMS::myEcm`,
+**                     `BMS::socEstimators`.
+**     -- `sh capstone/host/build.sh` also builds `_host_build/simulation-ekf`,
+**        and the simulation reports the errors of SOC against the simulated pack.
+**     -- The process noise of `SocEstimator::update` is scaled by the time since the last update.
+**     -- Field added `CellStates::ecms`, the parameters of each cell, which start from `BMS::myEcm`.
+**     -- `SOC_EKF` is experimental, and `SOC_ESTIMATOR` stays `SOC_COULOMB`,
+**        since the filter is less accurate than the coulomb counting with a calibrated current sensor
+**        unless the parameters are measured for each cell.
+** 14. The pack topology is given at compile time.
+**     -- Classes added `Unrolled`,
+**                      `PinList`,
+**                      `PackTopology`,
+**                      `CellStates`.
+**     -- Class eliminated `CellManager`.
+**     -- Macro eliminated `NO_CHARGER_PIN`.
+**     -- Fields eliminated `BMS::cells`,
+**                          `BMS::cellVs_measured`,
+**                          `BMS::cellVs_calibration`,
+**                          `BMS::cellVs_calibration2`,
+**                          `BMS::Qs_counters`,
+**                          `BMS::socEstimators`.
+**     -- Fields added `BMS::pack`,
+**                     `BMS::cell_states`.
+**     -- Method added `SocEstimator::init`.
+**     -- Changing the typedef `BMS::Pack` is all it takes to change the number of cells,
+**        and every loop over the cells is unrolled.
+** 15. The class `PinGroup` introduced.
+**     -- Macro added `PIN_GROUP_MAX`.
+**     -- Field added `BMS::dischargers`.
+**     -- `BMS::control` stages the states of every `DISCHARGER_pin` and commits them at once,
+**        which is a single masked write of `PORTx` per port on AVR.
+** 16. The data sheets moved into the flash.
+**     -- Function added `readFlash`.
+**     -- Fields added `AscList::ys_in_flash`,
+**                     `Map2d::table_in_flash`.
+**     -- Constructors of `AscList` and `Map2d` take `in_flash`.
+**     -- `Ocvs` and `Vcells` are placed by `PROGMEM`, which saves 404 bytes of SRAM on AVR.
+** 17. The data sheets are encoded in 16 bits.
+**     -- Function added `encodeU16`.
+**     -- Constructors added `AscList` for `uint16_t` codes with `base` and `unit`.
+**     -- Method added `AscList::get_x_by_y_with_codes`.
+**     -- Constructor added `Map2d` for entries of `Entry_t` with `base` and `unit`.
+**     -- `Ocvs` and `Vcells` are stored as codes of 0.1mV above 2.5V,
+**        which halves the flash they take on AVR.
+** 18. The checkpoints in the EEPROM introduced.
+**     -- Class added `EepromRing`.
+**     -- Macro added `EEPROM_RECORD_MAX`.
+**     -- Class added `BMS::Checkpoint`.
+**     -- Fields added `BMS::checkpoints`,
+**                     `BMS::last_checkpoint`,
+**                     `BMS::warm_start`,
+**                     `BMS::operating_seconds_0`.
+**     -- Methods added `BMS::checkpoint` (1/60Hz),
+**                      `BMS::persist` (100Hz).
+**     -- `BMS::setup` resumes `Qs` and the calibrations from the last checkpoint,
+**        and then it waits only 100ms for the first windows of the ADC sampler instead of the greeting.
+**     -- `BMS::attach` rejects the checkpoint if the soc of a cell at rest is off the ocv by more than `BMS::soc_tolerance`.
+**        Under a current, which keeps the cellVs off the ocv, it is trusted unchecked and `serr` says so.
+**     -- The record is zeroed before it is filled, because the crc of `EepromRing` covers its padding.
+**     -- `beginAdcSampler` clears the last windows of every `PinReader`.
+**     -- Files added `capstone/host/avr/eeprom.h`.
+** 19. The monotonic clock of 32-bit microseconds introduced.
+**     -- Type added `us_t`.
+**     -- Functions added `clockMicros`,
+**                        `setClockSource`.
+**     -- Methods added `Timer::getMicros`,
+**                      `Scheduler::untilNextDue`.
+**     -- `Timer`, `Scheduler`, `PinReader::collectSignal`, `CoulombCounter` and `SocEstimator` run on `clockMicros`,
+**        whose durations are wrap-safe subtractions of `us_t` instead of 64-bit `millis`.
+**     -- `Task::max_jitter` and `Task::max_duration` are measured in microseconds.
+**     -- The host simulation jumps over the idle time by `Sim::virtualMicros`.
+** 20. The lifecycle of the BMS driven by a transition table.
+**     -- Classes added `Transition`,
+**                     `StateMachine`.
+**     -- `BMS::bms_mode` is replaced by `BMS::lifecycle` over `BMS::lifecycle_table` in the flash,
+**        whose states are `detached`, `balancing`, `charging`, `finished` and `faulted`.
+**     -- `BMS::measure` raises the events, hence the transitions take place within 10ms instead of 100ms.
+**     -- Methods added `BMS::attach`,
+**                      `BMS::release`,
+**                      `BMS::trip`,
+**                      `BMS::dumpLifecycle`.
+**     -- `BMS::goodbye` cuts the power when every cell is charged and balanced.
+**        While charging, a cell is charged once it is within `V_tolerance` below `V_wanted` and `Iin` tapers below `I_charged`,
+**        or once it is above `V_wanted`,
+**        and `cells_charged` is raised only after `charged_ticks` passing ticks in a row of `BMS::control`.
+**     -- `I_attatched` is lowered from 300mA to 150mA, so that the state stays `charging` through the taper to `I_charged`.
+**        Hence the power is connected, `V_calibration` is applied, and the pack is not at rest for the checkpoint, above 150mA.
+**     -- The host simulation fails if the power is cut below 95% of the SOC of the pack,
+**        and `--charger A` sets the current of the simulated charger.
+**     -- `BMS::trip` cuts the power and latches `faulted` above `V_allowed_max` or `I_allowed_max`.
+**     -- The host simulation prints the transition table with `--graph`.
+** 21. The literals moved into the flash.
+**     -- Macro added `FLASH_STR`.
+**     -- Overloads added for `__FlashStringHelper const *` of `queueSerial`,
+**                                                         `SizedFormatter::putString`,
+**                                                         `LcdPrinter::print`,
+**                                                         `LcdPrinter::println`,
+**                                                         `SerialPrinter::operator<<`.
+**     -- The prefixes of `sout`, `serr` and `slog` are placed by `PROGMEM`.
+**     -- Every literal of the sketch is given by `F("...")`,
+**        which frees 681 bytes of SRAM on AVR with `MAJOR_VERSION == 2`.
+**     -- `StateMachine::dump` takes the names placed by `PROGMEM`.
+**     -- "capstone/host/build.sh" reports the literals left in the SRAM.
+** 22. The fast trip path on the ADC sampler introduced.
+**     -- Classes added `TripLimit`,
+**                     `TripGuard`.
+**     -- Macro added `TRIP_STRIKES`.
+**     -- Fields added `BMS::trip_limits`,
+**                     `BMS::guard`.
+**     -- The conversion-complete interrupt opens `powerIn_pin` when a cell or `Iin` crosses its limit,
+**        and `BMS::measure` only raises `fault_detected` from the latched fault code.
+**     -- `BMS::measure` tracks the limits in counts of the ADC from `arduino5V`,
+**        and the limit below `V_allowed_min` is armed only while operating.
+**     -- The host simulation emulates the ADC registers and the interrupt,
+**        and `--fault hours kind` reports the trip latency, at most 1.25ms in the sweep.
+**     -- `BMS::measure` computes the limits of `BMS::guard` again only when `arduino5V` drifts over `arduino5V_tolerance`
+**        or the pack starts or stops operating.
+** 23. The ADC sampler pipelined.
+**     -- The conversion-complete interrupt starts the next conversion before it processes the sample.
+**     -- `beginAdcSampler` restarts the windows of every `PinReader` together.
+**     -- Function added `countAdcScans`.
+**     -- `PinReader::takeSample` returns whether the sample completes a window.
+**     -- Functions added `holdAdcWindows`,
+**                       `releaseAdcWindows`.
+**     -- `BMS::measure` holds the windows of `arduino5V`, `cellVs` and `Iin` in a single critical section,
+**        hence none of them is replaced between the readings, and `BMS::Iin_pin` is sampled right after the taps.
+** 24. The windows of the ADC sampler adapt to the noise of each channel.
+**     -- Macros added `ADC_WINDOW_MIN`,
+**                     `ADC_WINDOW_MAX`,
+**                     `ADC_TARGET_ERROR`.
+**     -- The constructor of `PinReader` takes `target_error`.
+**     -- Methods added `PinReader::getWindowLength`,
+**                      `PinReader::getVariance`.
+**     -- A window ends at a multiple of its length in the rounds of the sampler,
+**        and its length is the least power of 2 which meets `target_error` under the running variance.
+**     -- `ADC_TARGET_ERROR` is an eighth of a count and `ADC_WINDOW_LEN` is 64,
+**        so that the taps are read as precisely as by `readSignal(10)` before the sampler.
+**     -- `BMS::stats` reports the window and the variance of every channel,
+**        in the frames of the type `0x02` with `TELEMETRY_BINARY`.
+**        Otherwise it prints one line per call, a task or a channel in turn, and runs at 1Hz;
+**        the channel to print next is the field `BMS::reader_to_report`.
+**     -- The host simulation gives the current sensor twice the noise of the other channels.
+** 25. No change for the resolution of the ADC sampler beyond 10 bits, which 1 and 2 already give.
+**     -- The sampler averages up to `ADC_WINDOW_MAX` samples in the background,
+**        and `PinReader::readSignalFixed` keeps `ADC_FRACTION_BITS` bits of the average below a count.
+**     -- `signalShift` of the voltage conversion already scales by `ADC_FRACTION_BITS`.
 */
 
 /* Circuit Archive